@@ -0,0 +1,76 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Free-running cycle counter, for profiling.
+
+#ifndef CLOUDS_DRIVERS_CYCLE_COUNTER_H_
+#define CLOUDS_DRIVERS_CYCLE_COUNTER_H_
+
+#include "stmlib/stmlib.h"
+
+#ifdef TEST
+#include <ctime>
+#else
+#include <stm32f4xx_conf.h>
+#endif
+
+namespace clouds {
+
+class CycleCounter {
+ public:
+  CycleCounter() { }
+  ~CycleCounter() { }
+#ifdef TEST
+  // On the host, ticks are nanoseconds.
+  static const uint32_t kTicksPerSecond = 1000000000;
+
+  static void Init() { }
+  static inline uint32_t Read() {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return static_cast<uint32_t>(t.tv_sec * 1000000000ULL + t.tv_nsec);
+  }
+#else
+  // On the module, ticks are CPU cycles.
+  static const uint32_t kTicksPerSecond = 168000000;
+
+  static void Init() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  }
+  static inline uint32_t Read() {
+    return DWT->CYCCNT;
+  }
+#endif
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(CycleCounter);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_DRIVERS_CYCLE_COUNTER_H_
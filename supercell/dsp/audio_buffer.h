@@ -36,6 +36,7 @@
 #include "stmlib/dsp/dsp.h"
 #include "stmlib/utils/dsp.h"
 
+#include "supercell/dsp/frame.h"
 #include "supercell/dsp/mu_law.h"
 
 const int32_t kCrossFadeSize = 256;
@@ -56,6 +57,10 @@ enum InterpolationMethod {
   INTERPOLATION_HERMITE
 };
 
+// Number of mu-law samples that ReadBlock() can decode in one go: enough for
+// a full block read two octaves up with the Hermite interpolator.
+const int32_t kReadBlockDecodeSize = 4 * kMaxBlockSize + 4;
+
 template<Resolution resolution>
 class AudioBuffer {
  public:
@@ -275,10 +280,111 @@ class AudioBuffer {
     return ((((a * t) - b_neg) * t + c) * t + x0) * scale;
   }
   
+  // Reads size samples at a fixed phase increment: out[i] is the same as
+  // Read<method>(start + (phase >> 16), phase & 0xffff), with phase advancing
+  // by phase_increment after each sample. When the block does not cross the
+  // end of the buffer, the wrap-around is checked only once and mu-law
+  // samples are decoded only once, instead of once per interpolator tap.
+  template<InterpolationMethod method>
+  inline void ReadBlock(
+      int32_t start,
+      int32_t phase,
+      int32_t phase_increment,
+      float* out,
+      size_t size) const {
+    if (!size) {
+      return;
+    }
+    int32_t last_phase = phase + static_cast<int32_t>(size - 1) * \
+        phase_increment;
+    int32_t first = start + (phase >> 16);
+    int32_t last = start + (last_phase >> 16);
+    int32_t lo = std::min(first, last);
+    int32_t hi = std::max(first, last);
+    int32_t wrap = lo >= size_ ? size_ : 0;
+    if (lo - wrap < 0 || hi - wrap >= size_) {
+      // The block crosses the end of the buffer.
+      while (size--) {
+        *out++ = Read<method>(start + (phase >> 16), phase & 65535);
+        phase += phase_increment;
+      }
+      return;
+    }
+    
+    start -= wrap;
+    if (resolution == RESOLUTION_16_BIT) {
+      ReadSpan<method>(
+          s16_, start, phase, phase_increment, 1.0f / 32768.0f, out, size);
+    } else if (resolution == RESOLUTION_8_BIT_MU_LAW) {
+      int32_t begin = lo - wrap;
+      int32_t end = hi - wrap + num_taps<method>();
+      if (end - begin <= kReadBlockDecodeSize) {
+        int16_t decoded[kReadBlockDecodeSize];
+        for (int32_t i = begin; i < end; ++i) {
+          decoded[i - begin] = MuLaw2Lin(s8_[i]);
+        }
+        ReadSpan<method>(
+            decoded, start - begin, phase, phase_increment, 1.0f / 32768.0f,
+            out, size);
+      } else {
+        while (size--) {
+          *out++ = Read<method>(start + (phase >> 16), phase & 65535);
+          phase += phase_increment;
+        }
+      }
+    } else {
+      ReadSpan<method>(
+          s8_, start, phase, phase_increment, 1.0f / 128.0f, out, size);
+    }
+  }
+  
   inline int32_t size() const { return size_; }
   inline int32_t head() const { return write_head_; }
   
  private:
+  template<InterpolationMethod method>
+  static inline int32_t num_taps() {
+    return method == INTERPOLATION_HERMITE ? 4 :
+        (method == INTERPOLATION_LINEAR ? 2 : 1);
+  }
+  
+  // Same interpolators as ReadZOH, ReadLinear and ReadHermite, on samples
+  // known not to wrap around.
+  template<InterpolationMethod method, typename T>
+  static inline void ReadSpan(
+      const T* s,
+      int32_t start,
+      int32_t phase,
+      int32_t phase_increment,
+      float scale,
+      float* out,
+      size_t size) {
+    while (size--) {
+      const T* x = &s[start + (phase >> 16)];
+      float t = static_cast<float>(static_cast<uint16_t>(phase)) / 65536.0f;
+      if (method == INTERPOLATION_ZOH) {
+        float x0 = x[0];
+        *out++ = x0 * scale;
+      } else if (method == INTERPOLATION_LINEAR) {
+        float x0 = x[0];
+        float x1 = x[1];
+        *out++ = (x0 + (x1 - x0) * t) * scale;
+      } else {
+        float xm1 = x[0];
+        float x0 = x[1];
+        float x1 = x[2];
+        float x2 = x[3];
+        const float c = (x1 - xm1) * 0.5f;
+        const float v = x0 - x1;
+        const float w = c + v;
+        const float a = w + v + (x2 - x0) * 0.5f;
+        const float b_neg = w + a;
+        *out++ = ((((a * t) - b_neg) * t + c) * t + x0) * scale;
+      }
+      phase += phase_increment;
+    }
+  }
+
   int16_t* s16_;
   int8_t* s8_;
   
@@ -0,0 +1,172 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Block conversions between the int16 codec frames and the float frames
+// processed by the DSP code.
+
+#ifndef CLOUDS_DSP_BLOCK_CONVERSION_H_
+#define CLOUDS_DSP_BLOCK_CONVERSION_H_
+
+#include "stmlib/stmlib.h"
+
+#include <cstring>
+
+#if defined(TEST) && defined(__SSE2__)
+  #include <emmintrin.h>
+  #define CLOUDS_BLOCK_CONVERSION_SSE2
+#endif
+
+#include "stmlib/dsp/dsp.h"
+
+#include "supercell/dsp/frame.h"
+
+namespace clouds {
+
+// One step of the one-pole smoothing of the mute levels.
+inline float MuteFadeStep(float fade, float target) {
+  return fade + 0.01f * (target - fade);
+}
+
+// Applies the mute fade to the input, in place and with the same truncation
+// to int16 as before - the dry signal is read back from it later - and
+// converts it to float. In mono, the two channels are mixed (mono_xfade
+// being the amount of right channel) and the result is copied on both sides.
+//
+// Once the fade has settled, it is constant over the whole block and the
+// conversion no longer depends on the previous sample.
+template<int32_t num_channels>
+inline void ConvertInput(
+    ShortFrame* input,
+    FloatFrame* output,
+    size_t size,
+    float target,
+    float* fade,
+    float mono_xfade) {
+  const float k = 1.0f / 32768.0f;
+  float f = *fade;
+  size_t i = 0;
+  if (MuteFadeStep(f, target) != f) {
+    for (; i < size; ++i) {
+      f = MuteFadeStep(f, target);
+      input[i].l = input[i].l * f;
+      input[i].r = input[i].r * f;
+      float l = static_cast<float>(input[i].l) * k;
+      float r = static_cast<float>(input[i].r) * k;
+      if (num_channels == 1) {
+        l = l * (1.0f - mono_xfade) + r * mono_xfade;
+        r = l;
+      }
+      output[i].l = l;
+      output[i].r = r;
+    }
+    *fade = f;
+    return;
+  }
+
+#ifdef CLOUDS_BLOCK_CONVERSION_SSE2
+  // Two frames at a time.
+  const __m128 gain = _mm_set1_ps(f);
+  const __m128 scale = _mm_set1_ps(k);
+  const __m128 mix = _mm_setr_ps(
+      1.0f - mono_xfade, mono_xfade, 1.0f - mono_xfade, mono_xfade);
+  for (; i + 2 <= size; i += 2) {
+    __m128i s16 = _mm_loadl_epi64(reinterpret_cast<__m128i*>(&input[i]));
+    __m128i s32 = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+    s32 = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(s32), gain));
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i*>(&input[i]), _mm_packs_epi32(s32, s32));
+    __m128 x = _mm_mul_ps(_mm_cvtepi32_ps(s32), scale);
+    if (num_channels == 1) {
+      x = _mm_mul_ps(x, mix);
+      x = _mm_add_ps(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+    _mm_storeu_ps(&output[i].l, x);
+  }
+#endif  // CLOUDS_BLOCK_CONVERSION_SSE2
+
+  for (; i < size; ++i) {
+    input[i].l = input[i].l * f;
+    input[i].r = input[i].r * f;
+    float l = static_cast<float>(input[i].l) * k;
+    float r = static_cast<float>(input[i].r) * k;
+    if (num_channels == 1) {
+      l = l * (1.0f - mono_xfade) + r * mono_xfade;
+      r = l;
+    }
+    output[i].l = l;
+    output[i].r = r;
+  }
+}
+
+// Saturates two samples to 16 bits and packs them into a frame.
+inline void StoreFrame(int32_t l, int32_t r, ShortFrame* frame) {
+#ifdef TEST
+  frame->l = stmlib::Clip16(l);
+  frame->r = stmlib::Clip16(r);
+#else
+  int32_t l_sat, r_sat;
+  uint32_t packed;
+  __asm ("ssat %0, %1, %2" : "=r" (l_sat) : "I" (16), "r" (l));
+  __asm ("ssat %0, %1, %2" : "=r" (r_sat) : "I" (16), "r" (r));
+  __asm ("pkhbt %0, %1, %2, lsl #16" : "=r" (packed) : "r" (l_sat), "r" (r_sat));
+  memcpy(frame, &packed, sizeof(packed));
+#endif  // TEST
+}
+
+// Soft-clips and converts a block of float frames to int16, the same as
+// stmlib::SoftConvert on each sample.
+inline void SoftConvertBlock(
+    const FloatFrame* input,
+    ShortFrame* output,
+    size_t size) {
+  size_t i = 0;
+#ifdef CLOUDS_BLOCK_CONVERSION_SSE2
+  // Two frames at a time. SoftLimit(x) = x (27 + x^2) / (27 + 9 x^2), with
+  // the operations in the same order as the scalar version.
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 c27 = _mm_set1_ps(27.0f);
+  const __m128 c9 = _mm_set1_ps(9.0f);
+  const __m128 scale = _mm_set1_ps(32768.0f);
+  for (; i + 2 <= size; i += 2) {
+    __m128 x = _mm_mul_ps(_mm_loadu_ps(&input[i].l), half);
+    __m128 num = _mm_mul_ps(x, _mm_add_ps(c27, _mm_mul_ps(x, x)));
+    __m128 den = _mm_add_ps(c27, _mm_mul_ps(_mm_mul_ps(c9, x), x));
+    __m128i s32 = _mm_cvttps_epi32(_mm_mul_ps(_mm_div_ps(num, den), scale));
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i*>(&output[i]), _mm_packs_epi32(s32, s32));
+  }
+#endif  // CLOUDS_BLOCK_CONVERSION_SSE2
+  for (; i < size; ++i) {
+    StoreFrame(
+        static_cast<int32_t>(stmlib::SoftLimit(input[i].l * 0.5f) * 32768.0f),
+        static_cast<int32_t>(stmlib::SoftLimit(input[i].r * 0.5f) * 32768.0f),
+        &output[i]);
+  }
+}
+
+}  // namespace clouds
+
+#endif  // CLOUDS_DSP_BLOCK_CONVERSION_H_
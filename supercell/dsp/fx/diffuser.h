@@ -41,18 +41,17 @@ class Diffuser {
   ~Diffuser() { }
   
   void Init(float* buffer) {
+    buffer_ = buffer;
     engine_.Init(buffer);
+    fixed_point_ = false;
   }
   
   void Process(FloatFrame* in_out, size_t size) {
-    typedef E::Reserve<126,
-      E::Reserve<180,
-      E::Reserve<269,
-      E::Reserve<444,
-      E::Reserve<151,
-      E::Reserve<205,
-      E::Reserve<245,
-      E::Reserve<405> > > > > > > > Memory;
+    if (fixed_point_) {
+      ProcessFixedPoint(in_out, size);
+      return;
+    }
+
     E::DelayLine<Memory, 0> apl1;
     E::DelayLine<Memory, 1> apl2;
     E::DelayLine<Memory, 2> apl3;
@@ -98,10 +97,96 @@ class Diffuser {
   void set_amount(float amount) {
     amount_ = amount;
   }
+
+  // Runs the diffuser on Q12 integers rather than floats, with 12-bit samples
+  // in the delay memory - which is cleared when this changes.
+  void set_fixed_point(bool fixed_point) {
+    if (fixed_point == fixed_point_) {
+      return;
+    }
+    fixed_point_ = fixed_point;
+    if (fixed_point_) {
+      fixed_point_engine_.Init(reinterpret_cast<uint16_t*>(buffer_));
+    } else {
+      engine_.Init(buffer_);
+    }
+  }
+
+  // The float and fixed-point engines share the layout.
+  static void ReportLayout(FxLayoutReport* report) {
+    E::Layout<Memory>::Report(report);
+  }
   
  private:
   typedef FxEngine<2048, FORMAT_32_BIT> E;
+  typedef FxEngine<2048, FORMAT_12_BIT> Q;
+  typedef E::Reserve<126,
+    E::Reserve<180,
+    E::Reserve<269,
+    E::Reserve<444,
+    E::Reserve<151,
+    E::Reserve<205,
+    E::Reserve<245,
+    E::Reserve<405> > > > > > > > Memory;
+  static const size_t kBlockSize = 16;
+
+  void ProcessFixedPoint(FloatFrame* in_out, size_t size) {
+    Q::DelayLine<Memory, 0> apl1;
+    Q::DelayLine<Memory, 1> apl2;
+    Q::DelayLine<Memory, 2> apl3;
+    Q::DelayLine<Memory, 3> apl4;
+    Q::DelayLine<Memory, 4> apr1;
+    Q::DelayLine<Memory, 5> apr2;
+    Q::DelayLine<Memory, 6> apr3;
+    Q::DelayLine<Memory, 7> apr4;
+    Q::Block b;
+    const int32_t kap = FxQ15(0.625f);
+    const float kFixedPointScale = 4096.0f;
+    const float amount = amount_;
+    int32_t wet[kBlockSize];
+    // Each allpass runs over a whole block before the next. The first one
+    // overwrites the end of the last one 1 + unused memory samples after it
+    // is read, which limits the size of the blocks.
+    STATIC_ASSERT(kBlockSize <= Q::Layout<Memory>::unused, block_too_long);
+    while (size) {
+      size_t block_size = std::min(size, static_cast<size_t>(kBlockSize));
+      fixed_point_engine_.Start(&b, block_size);
+
+      for (size_t i = 0; i < block_size; ++i) {
+        wet[i] = FxSaturate16(
+            static_cast<int32_t>(in_out[i].l * kFixedPointScale));
+      }
+      b.AllPass(apl1, wet, kap);
+      b.AllPass(apl2, wet, kap);
+      b.AllPass(apl3, wet, kap);
+      b.AllPass(apl4, wet, kap);
+      for (size_t i = 0; i < block_size; ++i) {
+        float w = static_cast<float>(wet[i]) / kFixedPointScale;
+        in_out[i].l += amount * (w - in_out[i].l);
+      }
+
+      for (size_t i = 0; i < block_size; ++i) {
+        wet[i] = FxSaturate16(
+            static_cast<int32_t>(in_out[i].r * kFixedPointScale));
+      }
+      b.AllPass(apr1, wet, kap);
+      b.AllPass(apr2, wet, kap);
+      b.AllPass(apr3, wet, kap);
+      b.AllPass(apr4, wet, kap);
+      for (size_t i = 0; i < block_size; ++i) {
+        float w = static_cast<float>(wet[i]) / kFixedPointScale;
+        in_out[i].r += amount * (w - in_out[i].r);
+      }
+
+      in_out += block_size;
+      size -= block_size;
+    }
+  }
+
   E engine_;
+  Q fixed_point_engine_;
+  float* buffer_;
+  bool fixed_point_;
   
   float amount_;
   DISALLOW_COPY_AND_ASSIGN(Diffuser);
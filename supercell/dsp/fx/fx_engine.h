@@ -30,12 +30,15 @@
 #define CLOUDS_DSP_FX_FX_ENGINE_H_
 
 #include <algorithm>
+#include <cstring>
 
 #include "stmlib/stmlib.h"
 
 #include "stmlib/dsp/dsp.h"
 #include "stmlib/dsp/cosine_oscillator.h"
 
+#include "supercell/dsp/frame.h"
+
 namespace clouds {
 
 #define TAIL , -1
@@ -95,6 +98,64 @@ struct DataType<FORMAT_32_BIT> {
   }
 };
 
+// Fixed-point arithmetic of the integer block operations (see Block), with
+// the saturation and dual 16-bit multiply-accumulate instructions of the
+// Cortex-M4 and their portable equivalent on the host. Only the interpolated
+// reads have two products to sum, and use the dual multiply-accumulate; the
+// allpass and low-pass recursions have one product per step.
+inline int32_t FxSaturate16(int32_t x) {
+#ifdef TEST
+  return stmlib::Clip16(x);
+#else
+  int32_t x_sat;
+  __asm ("ssat %0, %1, %2" : "=r" (x_sat) : "I" (16), "r" (x));
+  return x_sat;
+#endif  // TEST
+}
+
+// acc + x.lo * y.lo + x.hi * y.hi, on the signed halves of x and y.
+inline int32_t FxSmlad(uint32_t x, uint32_t y, int32_t acc) {
+#ifdef TEST
+  return acc + \
+      static_cast<int16_t>(x & 0xffff) * static_cast<int16_t>(y & 0xffff) + \
+      static_cast<int16_t>(x >> 16) * static_cast<int16_t>(y >> 16);
+#else
+  int32_t result;
+  __asm ("smlad %0, %1, %2, %3" : "=r" (result) : "r" (x), "r" (y), "r" (acc));
+  return result;
+#endif  // TEST
+}
+
+// End of a list of Reserve<>, shared by all engines so that a delay memory
+// layout can be used with engines of different formats.
+struct FxEmpty { };
+
+// Where the delay lines of an effect are in its memory, as reported by
+// FxEngine::Layout<>::Report() for the host tools.
+const int32_t kMaxFxDelayLines = 16;
+
+struct FxLayoutReport {
+  int32_t size;
+  int32_t num_lines;
+  int32_t footprint;
+  int32_t unused;
+  int32_t base[kMaxFxDelayLines];
+  int32_t length[kMaxFxDelayLines];
+};
+
+// x * g, g being a Q15 coefficient, truncated towards zero like the float to
+// integer conversions. Rounding down would add up to a DC offset in the
+// feedback loops, and rounding to the nearest would sustain limit cycles.
+inline int32_t FxMulQ15(int32_t x, int32_t g) {
+  int32_t product = x * g;
+  return (product + ((product >> 31) & 0x7fff)) >> 15;
+}
+
+// Converts a gain in [-1, 1] to a Q15 coefficient.
+inline int32_t FxQ15(float x) {
+  return stmlib::Clip16(static_cast<int32_t>(x * 32768.0f));
+}
+
 template<
     size_t size,
     Format format = FORMAT_12_BIT>
@@ -114,8 +175,10 @@ class FxEngine {
     write_ptr_ = 0;
   }
 
-  struct Empty { };
+  typedef FxEmpty Empty;
   
+  // Delay lines are laid out one after the other in the buffer, in the order
+  // in which they are reserved, with one sample between them.
   template<int32_t l, typename T = Empty>
   struct Reserve {
     typedef T Tail;
@@ -139,9 +202,50 @@ class FxEngine {
       base = 0
     };
   };
+  
+  // Number of delay lines, memory used by them, and memory left at the end of
+  // the buffer - between the last delay line and the first one. Report()
+  // also gives the base and length of each line.
+  template<typename Memory, typename Dummy = void>
+  struct Layout {
+    enum {
+      num_lines = Layout<typename Memory::Tail>::num_lines + 1,
+      footprint = DelayLine<Memory, num_lines - 1>::base + \
+          DelayLine<Memory, num_lines - 1>::length,
+      unused = size - footprint
+    };
+
+    static void Report(FxLayoutReport* report) {
+      STATIC_ASSERT(num_lines <= kMaxFxDelayLines, too_many_delay_lines);
+      report->size = size;
+      report->num_lines = num_lines;
+      report->footprint = footprint;
+      report->unused = unused;
+      Lines(&report->base[0], &report->length[0], 0);
+    }
+
+    static void Lines(int32_t* base, int32_t* length, int32_t offset) {
+      *base = offset;
+      *length = Memory::length;
+      Layout<typename Memory::Tail>::Lines(
+          base + 1, length + 1, offset + Memory::length + 1);
+    }
+  };
+  
+  template<typename Dummy>
+  struct Layout<Empty, Dummy> {
+    enum {
+      num_lines = 0
+    };
+
+    static void Lines(int32_t* base, int32_t* length, int32_t offset) { }
+  };
+
+  class Block;
 
   class Context {
    friend class FxEngine;
+   friend class Block;
    public:
     Context() { }
     ~Context() { }
@@ -316,11 +420,295 @@ class FxEngine {
     DISALLOW_COPY_AND_ASSIGN(Context);
   };
   
+  // Runs the delay lines over a block of up to kMaxBlockSize samples, one
+  // delay line after the other, rather than all of them for each sample. The
+  // samples of the block are held in arrays, and the taps of a delay line at
+  // a fixed offset are read and written as contiguous spans of the buffer,
+  // masked only when they wrap around.
+  //
+  // This gives the same output as long as no delay line reads what another
+  // one wrote less than a block earlier (no feedback loop shorter than the
+  // block), and as long as no delay line is written before what it
+  // overwrites has been read: the delay lines are next to each other in
+  // memory, and each one overwrites the end of the one before it 2 samples
+  // after it is read - the first one overwrites the end of the last one 2
+  // samples plus the unused memory after. Parts of a topology which do not
+  // allow it are run sample by sample with a Context (see Start()).
+  class Block {
+   friend class FxEngine;
+   public:
+    Block() { }
+    ~Block() { }
+
+    inline size_t block_size() const { return block_size_; }
+
+    // Sets up c for the n-th sample of the block.
+    inline void Start(Context* c, size_t n) const {
+      c->accumulator_ = 0.0f;
+      c->previous_read_ = 0.0f;
+      c->buffer_ = buffer_;
+      c->write_ptr_ = (write_ptr_ - static_cast<int32_t>(n)) & MASK;
+      c->lfo_value_[0] = lfo_value_[0][n];
+      c->lfo_value_[1] = lfo_value_[1][n];
+    }
+
+    // x += d[offset] * scale.
+    template<typename D>
+    inline void Read(D& d, int32_t offset, float scale, float* x) const {
+      STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+      int32_t start = span_start<D>(offset);
+      if (start >= 0) {
+        const T* r = &buffer_[start];
+        for (size_t n = 0; n < block_size_; ++n) {
+          x[n] += DataType<format>::Decompress(*r--) * scale;
+        }
+      } else {
+        start = write_ptr_ + D::base + tap<D>(offset);
+        for (size_t n = 0; n < block_size_; ++n) {
+          x[n] += DataType<format>::Decompress(buffer_[start-- & MASK]) * \
+              scale;
+        }
+      }
+    }
+
+    // d[offset] = x, then x *= scale.
+    template<typename D>
+    inline void Write(D& d, int32_t offset, float* x, float scale) const {
+      STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+      int32_t start = span_start<D>(offset);
+      if (start >= 0) {
+        T* w = &buffer_[start];
+        for (size_t n = 0; n < block_size_; ++n) {
+          *w-- = DataType<format>::Compress(x[n]);
+          x[n] *= scale;
+        }
+      } else {
+        start = write_ptr_ + D::base + tap<D>(offset);
+        for (size_t n = 0; n < block_size_; ++n) {
+          buffer_[start-- & MASK] = DataType<format>::Compress(x[n]);
+          x[n] *= scale;
+        }
+      }
+    }
+
+    // Same as Read(d TAIL, g) then WriteAllPass(d, -g) with a Context, for
+    // each sample of x.
+    template<typename D>
+    inline void AllPass(D& d, float* x, float g) const {
+      STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+      int32_t read_start = span_start<D>(-1);
+      int32_t write_start = span_start<D>(0);
+      if (read_start >= 0 && write_start >= 0) {
+        const T* r = &buffer_[read_start];
+        T* w = &buffer_[write_start];
+        for (size_t n = 0; n < block_size_; ++n) {
+          float tail = DataType<format>::Decompress(*r--);
+          float v = x[n] + tail * g;
+          *w-- = DataType<format>::Compress(v);
+          x[n] = v * -g + tail;
+        }
+      } else {
+        read_start = write_ptr_ + D::base + D::length - 1;
+        write_start = write_ptr_ + D::base;
+        for (size_t n = 0; n < block_size_; ++n) {
+          float tail = DataType<format>::Decompress(
+              buffer_[read_start-- & MASK]);
+          float v = x[n] + tail * g;
+          buffer_[write_start-- & MASK] = DataType<format>::Compress(v);
+          x[n] = v * -g + tail;
+        }
+      }
+    }
+
+    // x += d[offset + amplitude * lfo] * scale, linearly interpolated.
+    template<typename D>
+    inline void Interpolate(
+        D& d,
+        float offset,
+        LFOIndex index,
+        float amplitude,
+        float scale,
+        float* x) const {
+      STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+      for (size_t n = 0; n < block_size_; ++n) {
+        float o = offset + amplitude * lfo_value_[index][n];
+        MAKE_INTEGRAL_FRACTIONAL(o);
+        int32_t i = write_ptr_ - static_cast<int32_t>(n) + o_integral + \
+            D::base;
+        float a = DataType<format>::Decompress(buffer_[i & MASK]);
+        float b = DataType<format>::Decompress(buffer_[(i + 1) & MASK]);
+        x[n] += (a + (b - a) * o_fractional) * scale;
+      }
+    }
+
+    inline void Lp(float& state, float coefficient, float* x) const {
+      float s = state;
+      for (size_t n = 0; n < block_size_; ++n) {
+        s += coefficient * (x[n] - s);
+        x[n] = s;
+      }
+      state = s;
+    }
+
+    // The same operations on integer samples, for the 12-bit and 16-bit
+    // formats: x holds samples as stored in the buffer (Q12 or Q15),
+    // saturated to 16 bits after each operation, and the gains are Q15
+    // coefficients (see FxQ15()). A sample is read or written without any
+    // conversion to or from float.
+    template<typename D>
+    inline void Read(D& d, int32_t offset, int32_t scale, int32_t* x) const {
+      STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+      STATIC_ASSERT(format != FORMAT_32_BIT, integer_format_only);
+      int32_t start = span_start<D>(offset);
+      if (start >= 0) {
+        const T* r = &buffer_[start];
+        for (size_t n = 0; n < block_size_; ++n) {
+          int32_t r_n = static_cast<int16_t>(*r--);
+          x[n] = FxSaturate16(x[n] + FxMulQ15(r_n, scale));
+        }
+      } else {
+        start = write_ptr_ + D::base + tap<D>(offset);
+        for (size_t n = 0; n < block_size_; ++n) {
+          int32_t r = static_cast<int16_t>(buffer_[start-- & MASK]);
+          x[n] = FxSaturate16(x[n] + FxMulQ15(r, scale));
+        }
+      }
+    }
+
+    template<typename D>
+    inline void Write(D& d, int32_t offset, const int32_t* x) const {
+      STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+      STATIC_ASSERT(format != FORMAT_32_BIT, integer_format_only);
+      int32_t start = span_start<D>(offset);
+      if (start >= 0) {
+        T* w = &buffer_[start];
+        for (size_t n = 0; n < block_size_; ++n) {
+          *w-- = static_cast<T>(x[n]);
+        }
+      } else {
+        start = write_ptr_ + D::base + tap<D>(offset);
+        for (size_t n = 0; n < block_size_; ++n) {
+          buffer_[start-- & MASK] = static_cast<T>(x[n]);
+        }
+      }
+    }
+
+    template<typename D>
+    inline void AllPass(D& d, int32_t* x, int32_t g) const {
+      STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+      STATIC_ASSERT(format != FORMAT_32_BIT, integer_format_only);
+      int32_t read_start = span_start<D>(-1);
+      int32_t write_start = span_start<D>(0);
+      if (read_start >= 0 && write_start >= 0) {
+        const T* r = &buffer_[read_start];
+        T* w = &buffer_[write_start];
+        for (size_t n = 0; n < block_size_; ++n) {
+          int32_t tail = static_cast<int16_t>(*r--);
+          int32_t v = FxSaturate16(x[n] + FxMulQ15(tail, g));
+          *w-- = static_cast<T>(v);
+          x[n] = FxSaturate16(tail - FxMulQ15(v, g));
+        }
+      } else {
+        read_start = write_ptr_ + D::base + D::length - 1;
+        write_start = write_ptr_ + D::base;
+        for (size_t n = 0; n < block_size_; ++n) {
+          int32_t tail = static_cast<int16_t>(buffer_[read_start-- & MASK]);
+          int32_t v = FxSaturate16(x[n] + FxMulQ15(tail, g));
+          buffer_[write_start-- & MASK] = static_cast<T>(v);
+          x[n] = FxSaturate16(tail - FxMulQ15(v, g));
+        }
+      }
+    }
+
+    // The two samples around the tap are read as one word and weighted by a
+    // single dual multiply-accumulate, with Q14 interpolation weights.
+    template<typename D>
+    inline void Interpolate(
+        D& d,
+        float offset,
+        LFOIndex index,
+        float amplitude,
+        int32_t scale,
+        int32_t* x) const {
+      STATIC_ASSERT(D::base + D::length <= size, delay_memory_full);
+      STATIC_ASSERT(format != FORMAT_32_BIT, integer_format_only);
+      for (size_t n = 0; n < block_size_; ++n) {
+        float o = offset + amplitude * lfo_value_[index][n];
+        MAKE_INTEGRAL_FRACTIONAL(o);
+        int32_t i = (write_ptr_ - static_cast<int32_t>(n) + o_integral + \
+            D::base) & MASK;
+        uint32_t ab;
+        if (i != MASK) {
+          memcpy(&ab, &buffer_[i], sizeof(ab));
+        } else {
+          ab = buffer_[MASK] | (static_cast<uint32_t>(buffer_[0]) << 16);
+        }
+        int32_t fractional = static_cast<int32_t>(o_fractional * 16384.0f);
+        uint32_t weights = (16384 - fractional) | (fractional << 16);
+        int32_t r = FxSmlad(ab, weights, 1 << 13) >> 14;
+        x[n] = FxSaturate16(x[n] + FxMulQ15(r, scale));
+      }
+    }
+
+    inline void Lp(int32_t& state, int32_t coefficient, int32_t* x) const {
+      int32_t s = state;
+      for (size_t n = 0; n < block_size_; ++n) {
+        s += FxMulQ15(FxSaturate16(x[n] - s), coefficient);
+        x[n] = s;
+      }
+      state = s;
+    }
+
+   private:
+    template<typename D>
+    static inline int32_t tap(int32_t offset) {
+      return offset == -1 ? D::length - 1 : offset;
+    }
+
+    // Index of the tap at offset for the first sample of the block; -1 if
+    // the span of the block wraps around the start of the buffer.
+    template<typename D>
+    inline int32_t span_start(int32_t offset) const {
+      int32_t start = (write_ptr_ + D::base + tap<D>(offset)) & MASK;
+      return start >= static_cast<int32_t>(block_size_) - 1 ? start : -1;
+    }
+
+    T* buffer_;
+    int32_t write_ptr_;  // Of the first sample, then one less per sample.
+    size_t block_size_;
+    float lfo_value_[2][kMaxBlockSize];
+
+    DISALLOW_COPY_AND_ASSIGN(Block);
+  };
+
   inline void SetLFOFrequency(LFOIndex index, float frequency) {
     lfo_[index].template Init<stmlib::COSINE_OSCILLATOR_APPROXIMATE>(
         frequency * 32.0f);
   }
   
+  // Moves to the next block_size samples, with the same pointer and LFO
+  // updates as block_size calls to Start(Context*).
+  inline void Start(Block* b, size_t block_size) {
+    b->buffer_ = buffer_;
+    b->block_size_ = block_size;
+    for (size_t n = 0; n < block_size; ++n) {
+      --write_ptr_;
+      if (write_ptr_ < 0) {
+        write_ptr_ += size;
+      }
+      if (n == 0) {
+        b->write_ptr_ = write_ptr_;
+      }
+      if ((write_ptr_ & 31) == 0) {
+        b->lfo_value_[0][n] = lfo_[0].Next();
+        b->lfo_value_[1][n] = lfo_[1].Next();
+      } else {
+        b->lfo_value_[0][n] = lfo_[0].value();
+        b->lfo_value_[1][n] = lfo_[1].value();
+      }
+    }
+  }
+
   inline void Start(Context* c) {
     --write_ptr_;
     if (write_ptr_ < 0) {
@@ -41,7 +41,7 @@ class Oliverb {
   Oliverb() { }
   ~Oliverb() { }
 
-  void Init(uint16_t* buffer) {
+  void Init(uint16_t* buffer, RandomGenerator* random) {
     engine_.Init(buffer);
     diffusion_ = 0.625f;
     size_ = 1.0f;
@@ -57,7 +57,7 @@ class Oliverb {
     pitch_shift_amount_ = 1.0f;
     level_ = 0.0f;
     for (int i=0; i<9; i++)
-      lfo_[i].Init();
+      lfo_[i].Init(random);
   }
 
   void Process(FloatFrame* in_out, size_t size) {
@@ -62,7 +62,6 @@ class PitchShifter {
   }
   
   void Process(FloatFrame* input_output) {
-    typedef E::Reserve<2047, E::Reserve<2047> > Memory;
     E::DelayLine<Memory, 0> left;
     E::DelayLine<Memory, 1> right;
     E::Context c;
@@ -115,9 +114,14 @@ class PitchShifter {
     float target_size = 128.0f + (2047.0f - 128.0f) * size * size * size;
     ONE_POLE(size_, target_size, 0.05f)
   }
+
+  static void ReportLayout(FxLayoutReport* report) {
+    E::Layout<Memory>::Report(report);
+  }
   
  private:
   typedef FxEngine<4096, FORMAT_16_BIT> E;
+  typedef E::Reserve<2047, E::Reserve<2047> > Memory;
   E engine_;
   float phase_;
   float ratio_;
@@ -46,23 +46,15 @@ class Reverb {
     engine_.SetLFOFrequency(LFO_2, 0.3f / 32000.0f);
     lp_ = 0.7f;
     diffusion_ = 0.625f;
+    fixed_point_ = false;
   }
 
   void Process(FloatFrame* in_out, size_t size) {
-    // This is the Griesinger topology described in the Dattorro paper
-    // (4 AP diffusers on the input, then a loop of 2x 2AP+1Delay).
-    // Modulation is applied in the loop of the first diffuser AP for additional
-    // smearing; and to the two long delays for a slow shimmer/chorus effect.
-    typedef E::Reserve<113,
-      E::Reserve<162,
-      E::Reserve<241,
-      E::Reserve<399,
-      E::Reserve<1653,
-      E::Reserve<2038,
-      E::Reserve<3411,
-      E::Reserve<1913,
-      E::Reserve<1663,
-      E::Reserve<4782> > > > > > > > > > Memory;
+    if (fixed_point_) {
+      ProcessFixedPoint(in_out, size);
+      return;
+    }
+
     E::DelayLine<Memory, 0> ap1;
     E::DelayLine<Memory, 1> ap2;
     E::DelayLine<Memory, 2> ap3;
@@ -74,6 +66,7 @@ class Reverb {
     E::DelayLine<Memory, 8> dap2b;
     E::DelayLine<Memory, 9> del2;
     E::Context c;
+    E::Block b;
 
     const float kap = diffusion_;
     const float klp = lp_;
@@ -84,55 +77,64 @@ class Reverb {
     float lp_1 = lp_decay_1_;
     float lp_2 = lp_decay_2_;
 
-    while (size--) {
-      float wet;
-      float apout = 0.0f;
-      engine_.Start(&c);
+    float apout[kMaxBlockSize];
+    float feedback[kMaxBlockSize];
+    float wet[kMaxBlockSize];
+    while (size) {
+      size_t block_size = std::min(size, kMaxBlockSize);
+      engine_.Start(&b, block_size);
+
+      // The end of del2 is overwritten by AP1 right after being read: del2 is
+      // read first.
+      std::fill(&feedback[0], &feedback[block_size], 0.0f);
+      b.Interpolate(del2, 4680.0f, LFO_2, 100.0f, krt, feedback);
 
-      // Smear AP1 inside the loop.
-      c.Interpolate(ap1, 10.0f, LFO_1, 60.0f, 1.0f);
-      c.Write(ap1, 100, 0.0f);
+      // AP1 reads back what it wrote 10 to 70 samples before, and its smear
+      // 12 samples before: it runs sample by sample. All the other delays
+      // are longer than a block.
+      for (size_t i = 0; i < block_size; ++i) {
+        b.Start(&c, i);
 
-      c.Read(in_out->l + in_out->r, gain);
+        // Smear AP1 inside the loop.
+        c.Interpolate(ap1, 10.0f, LFO_1, 60.0f, 1.0f);
+        c.Write(ap1, 100, 0.0f);
 
-      // Diffuse through 4 allpasses.
-      c.Read(ap1 TAIL, kap);
-      c.WriteAllPass(ap1, -kap);
-      c.Read(ap2 TAIL, kap);
-      c.WriteAllPass(ap2, -kap);
-      c.Read(ap3 TAIL, kap);
-      c.WriteAllPass(ap3, -kap);
-      c.Read(ap4 TAIL, kap);
-      c.WriteAllPass(ap4, -kap);
-      c.Write(apout);
+        c.Read(in_out[i].l + in_out[i].r, gain);
+        c.Read(ap1 TAIL, kap);
+        c.WriteAllPass(ap1, -kap);
+        c.Write(apout[i]);
+      }
+
+      // Diffuse through the 3 other allpasses.
+      b.AllPass(ap2, apout, kap);
+      b.AllPass(ap3, apout, kap);
+      b.AllPass(ap4, apout, kap);
 
       // Main reverb loop.
-      c.Load(apout);
-      c.Interpolate(del2, 4680.0f, LFO_2, 100.0f, krt);
-      c.Lp(lp_1, klp);
-      c.Read(dap1a TAIL, -kap);
-      c.WriteAllPass(dap1a, kap);
-      c.Read(dap1b TAIL, kap);
-      c.WriteAllPass(dap1b, -kap);
-      c.Write(del1, 2.0f);
-      c.Write(wet, 0.0f);
-
-      in_out->l += (wet - in_out->l) * amount;
-
-      c.Load(apout);
-      // c.Interpolate(del1, 4450.0f, LFO_1, 50.0f, krt);
-      c.Read(del1 TAIL, krt);
-      c.Lp(lp_2, klp);
-      c.Read(dap2a TAIL, kap);
-      c.WriteAllPass(dap2a, -kap);
-      c.Read(dap2b TAIL, -kap);
-      c.WriteAllPass(dap2b, kap);
-      c.Write(del2, 2.0f);
-      c.Write(wet, 0.0f);
-
-      in_out->r += (wet - in_out->r) * amount;
-
-      ++in_out;
+      for (size_t i = 0; i < block_size; ++i) {
+        wet[i] = apout[i] + feedback[i];
+      }
+      b.Lp(lp_1, klp, wet);
+      b.AllPass(dap1a, wet, -kap);
+      b.AllPass(dap1b, wet, kap);
+      b.Write(del1, 0, wet, 2.0f);
+      for (size_t i = 0; i < block_size; ++i) {
+        in_out[i].l += (wet[i] - in_out[i].l) * amount;
+      }
+
+      std::copy(&apout[0], &apout[block_size], &wet[0]);
+      // b.Interpolate(del1, 4450.0f, LFO_1, 50.0f, krt, wet);
+      b.Read(del1 TAIL, krt, wet);
+      b.Lp(lp_2, klp, wet);
+      b.AllPass(dap2a, wet, kap);
+      b.AllPass(dap2b, wet, -kap);
+      b.Write(del2, 0, wet, 2.0f);
+      for (size_t i = 0; i < block_size; ++i) {
+        in_out[i].r += (wet[i] - in_out[i].r) * amount;
+      }
+
+      in_out += block_size;
+      size -= block_size;
     }
 
     lp_decay_1_ = lp_1;
@@ -159,8 +161,120 @@ class Reverb {
     lp_ = lp;
   }
 
+  // Runs the reverb on Q12 integers rather than floats: the samples of the
+  // delay memory are the same, so this can be changed at any time.
+  inline void set_fixed_point(bool fixed_point) {
+    fixed_point_ = fixed_point;
+  }
+
+  static void ReportLayout(FxLayoutReport* report) {
+    E::Layout<Memory>::Report(report);
+  }
+
  private:
   typedef FxEngine<16384, FORMAT_12_BIT> E;
+
+  // This is the Griesinger topology described in the Dattorro paper
+  // (4 AP diffusers on the input, then a loop of 2x 2AP+1Delay).
+  // Modulation is applied in the loop of the first diffuser AP for additional
+  // smearing; and to the two long delays for a slow shimmer/chorus effect.
+  typedef E::Reserve<113,
+    E::Reserve<162,
+    E::Reserve<241,
+    E::Reserve<399,
+    E::Reserve<1653,
+    E::Reserve<2038,
+    E::Reserve<3411,
+    E::Reserve<1913,
+    E::Reserve<1663,
+    E::Reserve<4782> > > > > > > > > > Memory;
+
+  void ProcessFixedPoint(FloatFrame* in_out, size_t size) {
+    E::DelayLine<Memory, 0> ap1;
+    E::DelayLine<Memory, 1> ap2;
+    E::DelayLine<Memory, 2> ap3;
+    E::DelayLine<Memory, 3> ap4;
+    E::DelayLine<Memory, 4> dap1a;
+    E::DelayLine<Memory, 5> dap1b;
+    E::DelayLine<Memory, 6> del1;
+    E::DelayLine<Memory, 7> dap2a;
+    E::DelayLine<Memory, 8> dap2b;
+    E::DelayLine<Memory, 9> del2;
+    E::Context c;
+    E::Block b;
+
+    const float kap = diffusion_;
+    const float gain = input_gain_;
+    const float amount = amount_;
+    const int32_t kap_q = FxQ15(diffusion_);
+    const int32_t klp_q = FxQ15(lp_);
+    const int32_t krt_q = FxQ15(reverb_time_);
+    // Scale of the 12-bit samples of the delay memory.
+    const float kFixedPointScale = 4096.0f;
+    // The output of the delays is scaled by 2, as in Process().
+    const float kOutputScale = 2.0f / kFixedPointScale;
+
+    int32_t lp_1 = static_cast<int32_t>(lp_decay_1_ * kFixedPointScale);
+    int32_t lp_2 = static_cast<int32_t>(lp_decay_2_ * kFixedPointScale);
+
+    int32_t apout[kMaxBlockSize];
+    int32_t feedback[kMaxBlockSize];
+    int32_t wet[kMaxBlockSize];
+    while (size) {
+      size_t block_size = std::min(size, kMaxBlockSize);
+      engine_.Start(&b, block_size);
+
+      std::fill(&feedback[0], &feedback[block_size], 0);
+      b.Interpolate(del2, 4680.0f, LFO_2, 100.0f, krt_q, feedback);
+
+      // The input and the smeared AP1 stay in float, sample by sample.
+      for (size_t i = 0; i < block_size; ++i) {
+        float x;
+        b.Start(&c, i);
+        c.Interpolate(ap1, 10.0f, LFO_1, 60.0f, 1.0f);
+        c.Write(ap1, 100, 0.0f);
+        c.Read(in_out[i].l + in_out[i].r, gain);
+        c.Read(ap1 TAIL, kap);
+        c.WriteAllPass(ap1, -kap);
+        c.Write(x);
+        apout[i] = FxSaturate16(static_cast<int32_t>(x * kFixedPointScale));
+      }
+
+      b.AllPass(ap2, apout, kap_q);
+      b.AllPass(ap3, apout, kap_q);
+      b.AllPass(ap4, apout, kap_q);
+
+      for (size_t i = 0; i < block_size; ++i) {
+        wet[i] = FxSaturate16(apout[i] + feedback[i]);
+      }
+      b.Lp(lp_1, klp_q, wet);
+      b.AllPass(dap1a, wet, -kap_q);
+      b.AllPass(dap1b, wet, kap_q);
+      b.Write(del1, 0, wet);
+      for (size_t i = 0; i < block_size; ++i) {
+        float w = static_cast<float>(wet[i]) * kOutputScale;
+        in_out[i].l += (w - in_out[i].l) * amount;
+      }
+
+      std::copy(&apout[0], &apout[block_size], &wet[0]);
+      b.Read(del1 TAIL, krt_q, wet);
+      b.Lp(lp_2, klp_q, wet);
+      b.AllPass(dap2a, wet, kap_q);
+      b.AllPass(dap2b, wet, -kap_q);
+      b.Write(del2, 0, wet);
+      for (size_t i = 0; i < block_size; ++i) {
+        float w = static_cast<float>(wet[i]) * kOutputScale;
+        in_out[i].r += (w - in_out[i].r) * amount;
+      }
+
+      in_out += block_size;
+      size -= block_size;
+    }
+
+    lp_decay_1_ = static_cast<float>(lp_1) / kFixedPointScale;
+    lp_decay_2_ = static_cast<float>(lp_2) / kFixedPointScale;
+  }
+
   E engine_;
 
   float amount_;
@@ -172,6 +286,8 @@ class Reverb {
   float lp_decay_1_;
   float lp_decay_2_;
 
+  bool fixed_point_;
+
   DISALLOW_COPY_AND_ASSIGN(Reverb);
 };
 
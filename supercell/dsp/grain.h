@@ -34,11 +34,14 @@
 #include "stmlib/dsp/dsp.h"
 
 #include "supercell/dsp/audio_buffer.h"
+#include "supercell/dsp/frame.h"
 
 #include "supercell/resources.h"
 
 namespace clouds {
 
+const int32_t kMaxNumGrains = 40;
+
 const float slope_response[4] = { 1.3f, 1.0f, 1.0f, 1.0f };
 const float bias_response[4] = { 1.0f, 2.0f - 1.0f/500.0f, 1.0f/500.0f, 1.0f };
 
@@ -106,12 +109,14 @@ class Grain {
     recommended_quality_ = recommended_quality;
   }
   
-  inline void RenderEnvelope(float* destination, size_t size) {
+  // Returns the number of samples rendered before the end of the grain.
+  inline size_t RenderEnvelope(float* destination, size_t size) {
     const float increment = envelope_phase_increment_;
     const float slope = envelope_slope_;
     const float bias = envelope_bias_;
 
     float phase = envelope_phase_;
+    float* start = destination;
     while (size--) {
       float gain = phase <= bias ?
         phase * slope / bias :
@@ -125,6 +130,7 @@ class Grain {
       *destination++ = gain;
     }
     envelope_phase_ = phase;
+    return destination - start;
   }
   
   template<int32_t num_channels, GrainQuality quality, Resolution resolution>
@@ -145,37 +151,32 @@ class Grain {
       --pre_delay_;
     }
     
-    // Pre-render the envelope in one pass.
-    RenderEnvelope(envelope, size);
+    // Pre-render the envelope and the samples in one pass each.
+    size_t num_samples = RenderEnvelope(envelope, size);
+    float samples[kMaxNumChannels][kMaxBlockSize];
+    for (int32_t i = 0; i < num_channels; ++i) {
+      buffer[i].template ReadBlock<InterpolationMethod(quality)>(
+          first_sample_, phase_, phase_increment_, samples[i], num_samples);
+    }
 
-    const int32_t phase_increment = phase_increment_;
-    const int32_t first_sample = first_sample_;
     const float gain_l = gain_l_;
     const float gain_r = gain_r_;
-    int32_t phase = phase_;
-    while (size--) {
-      int32_t sample_index = first_sample + (phase >> 16);
-
-      float gain = *envelope++;
-      if (gain == -1.0f) {
-        active_ = false;
-        break;
-      }
-
-      float l = buffer[0].template Read<InterpolationMethod(quality)>(
-          sample_index, phase & 65535) * gain;
+    for (size_t i = 0; i < num_samples; ++i) {
+      float gain = envelope[i];
+      float l = samples[0][i] * gain;
       if (num_channels == 1) {
         *destination++ += l * gain_l;
         *destination++ += l * gain_r;
       } else if (num_channels == 2) {
-        float r = buffer[1].template Read<InterpolationMethod(quality)>(
-            sample_index, phase & 65535) * gain;
+        float r = samples[1][i] * gain;
         *destination++ += l * gain_l + r * (1.0f - gain_r);
         *destination++ += r * gain_r + l * (1.0f - gain_l);
       }
-      phase += phase_increment;
     }
-    phase_ = phase;
+    phase_ += static_cast<int32_t>(num_samples) * phase_increment_;
+    if (num_samples < size) {
+      active_ = false;
+    }
   }
   
   inline bool active() { return active_; }
@@ -0,0 +1,146 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// Adapts the polyphony and interpolation quality of the granular player to
+// the measured cost of each block.
+//
+// The fixed grain counts of the original firmware are sized for the worst
+// case (all grains pitched up and interpolated at the highest quality), which
+// leaves most of the budget unused the rest of the time. Instead, the time
+// taken by each call to Process() is compared to the duration of the block,
+// and the load smoothed with a fast attack and a slow release:
+//   - above kHighLoad, the scheduler steps down: it first gives back the
+//     grains it added above the nominal count, then lowers the quality of new
+//     grains (Hermite -> linear -> zero-order hold), then removes grains down
+//     to half the nominal count;
+//   - below kLowLoad for long enough, it retraces these steps up, and adds
+//     grains above the nominal count up to kMaxNumGrains;
+//   - when a single block comes close to overrunning, no new grain is started
+//     until the load drops - this is the only action with an immediate effect,
+//     since grains already playing keep their quality until they end.
+
+#ifndef CLOUDS_DSP_GRAIN_SCHEDULER_H_
+#define CLOUDS_DSP_GRAIN_SCHEDULER_H_
+
+#include "stmlib/stmlib.h"
+
+#include "supercell/dsp/grain.h"
+
+namespace clouds {
+
+// Fractions of the block duration.
+const float kCriticalLoad = 0.95f;
+const float kHighLoad = 0.8f;
+const float kLowLoad = 0.5f;
+
+class GrainScheduler {
+ public:
+  GrainScheduler() { }
+  ~GrainScheduler() { }
+
+  void Init(int32_t nominal_num_grains) {
+    nominal_num_grains_ = nominal_num_grains;
+    min_num_grains_ = nominal_num_grains / 2;
+    num_grains_ = nominal_num_grains;
+    max_quality_ = GRAIN_QUALITY_HIGH;
+    hold_ = false;
+    load_ = 0.0f;
+    overload_blocks_ = 0;
+    headroom_blocks_ = 0;
+  }
+
+  // Called after each block, with the time spent processing it and the
+  // duration of the block, in the same unit.
+  void Update(uint32_t elapsed, uint32_t budget) {
+    float load = static_cast<float>(elapsed) / static_cast<float>(budget);
+    hold_ = load > kCriticalLoad;
+    load_ += (load - load_) * (load > load_ ? 0.5f : 0.01f);
+
+    if (load_ > kHighLoad) {
+      headroom_blocks_ = 0;
+      if (++overload_blocks_ >= kStepDownBlocks) {
+        StepDown();
+        overload_blocks_ = 0;
+      }
+    } else if (load_ < kLowLoad) {
+      overload_blocks_ = 0;
+      if (++headroom_blocks_ >= kStepUpBlocks) {
+        StepUp();
+        headroom_blocks_ = 0;
+      }
+    } else {
+      overload_blocks_ = 0;
+      headroom_blocks_ = 0;
+    }
+  }
+
+  inline int32_t num_grains() const { return num_grains_; }
+  inline GrainQuality max_quality() const { return max_quality_; }
+  inline bool hold() const { return hold_; }
+  inline float load() const { return load_; }
+
+ private:
+  // New settings only apply to new grains: leave some time to the grains
+  // already playing to be replaced before stepping down again.
+  static const int32_t kStepDownBlocks = 32;
+  static const int32_t kStepUpBlocks = 256;
+
+  void StepDown() {
+    if (num_grains_ > nominal_num_grains_) {
+      --num_grains_;
+    } else if (max_quality_ != GRAIN_QUALITY_LOW) {
+      max_quality_ = static_cast<GrainQuality>(max_quality_ - 1);
+    } else if (num_grains_ > min_num_grains_) {
+      --num_grains_;
+    }
+  }
+
+  void StepUp() {
+    if (num_grains_ < nominal_num_grains_) {
+      ++num_grains_;
+    } else if (max_quality_ != GRAIN_QUALITY_HIGH) {
+      max_quality_ = static_cast<GrainQuality>(max_quality_ + 1);
+    } else if (num_grains_ < kMaxNumGrains) {
+      ++num_grains_;
+    }
+  }
+
+  int32_t nominal_num_grains_;
+  int32_t min_num_grains_;
+  int32_t num_grains_;
+  GrainQuality max_quality_;
+  bool hold_;
+  float load_;
+  int32_t overload_blocks_;
+  int32_t headroom_blocks_;
+
+  DISALLOW_COPY_AND_ASSIGN(GrainScheduler);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_DSP_GRAIN_SCHEDULER_H_
@@ -30,11 +30,13 @@
 
 #include <cstring>
 
+#include "supercell/drivers/cycle_counter.h"
 #include "supercell/drivers/debug_pin.h"
 
 #include "stmlib/dsp/parameter_interpolator.h"
 #include "stmlib/utils/buffer_allocator.h"
 
+#include "supercell/dsp/block_conversion.h"
 #include "supercell/resources.h"
 
 namespace clouds {
@@ -42,6 +44,12 @@ namespace clouds {
 using namespace std;
 using namespace stmlib;
 
+#ifdef PROFILE_STAGES
+#define PROFILE_STAGE(stage) profiler_.Mark(stage)
+#else
+#define PROFILE_STAGE(stage) do { } while (0)
+#endif  // PROFILE_STAGES
+
 void GranularProcessor::Init(
     void* large_buffer, size_t large_buffer_size,
     void* small_buffer, size_t small_buffer_size) {
@@ -52,10 +60,19 @@ void GranularProcessor::Init(
 
   num_channels_ = 2;
   low_fidelity_ = false;
+  spectral_fft_size_ = kMaxFftSize;
+  spectral_hop_ratio_ = 4;
+  spectral_texture_format_ = TEXTURE_FORMAT_FLOAT;
+  dry_delay_ = false;
+  dry_delay_size_ = 0;
   bypass_ = false;
 
+  random_.Init();
+  CycleCounter::Init();
+
   src_down_.Init();
   src_up_.Init();
+  src_dry_down_.Init();
 
   phase_vocoder_.Init();
 
@@ -65,9 +82,17 @@ void GranularProcessor::Init(
   reset_buffers_ = true;
   mute_in_ = false;
   mute_out_ = false;
+  adaptive_grains_ = false;
+  decimated_post_processing_ = false;
+  fixed_point_post_processing_ = false;
+  paired_transforms_ = false;
   mute_in_fade_ = 0.0f;
   mute_out_fade_ = 0.0f;
   dry_wet_ = 0.0f;
+
+#ifdef PROFILE_STAGES
+  profiler_.Init();
+#endif  // PROFILE_STAGES
 }
 
 void GranularProcessor::ResetFilters() {
@@ -78,6 +103,25 @@ void GranularProcessor::ResetFilters() {
   }
 }
 
+void GranularProcessor::DelayDry(
+    const ShortFrame* input,
+    ShortFrame* output,
+    size_t size) {
+  int16_t* line_l = dry_delay_line_[0];
+  int16_t* line_r = dry_delay_line_[1];
+  int32_t ptr = dry_delay_ptr_;
+  for (size_t i = 0; i < size; ++i) {
+    output[i].l = line_l[ptr];
+    output[i].r = line_r[ptr];
+    line_l[ptr] = input[i].l;
+    line_r[ptr] = input[i].r;
+    if (++ptr >= dry_delay_size_) {
+      ptr = 0;
+    }
+  }
+  dry_delay_ptr_ = ptr;
+}
+
 void GranularProcessor::ProcessGranular(
     FloatFrame* input,
     FloatFrame* output,
@@ -146,19 +190,8 @@ void GranularProcessor::ProcessGranular(
       break;
 
     case PLAYBACK_MODE_SPECTRAL:
-      {
-        parameters_.spectral.quantization = parameters_.texture;
-        parameters_.spectral.refresh_rate = 0.01f + 0.99f * parameters_.density;
-        float warp = parameters_.size - 0.5f;
-        parameters_.spectral.warp = 4.0f * warp * warp * warp + 0.5f;
-
-        float randomization = parameters_.density - 0.5f;
-        randomization *= randomization * 4.2f;
-        randomization -= 0.05f;
-        CONSTRAIN(randomization, 0.0f, 1.0f);
-        parameters_.spectral.phase_randomization = randomization;
-        phase_vocoder_.Process(parameters_, input, output, size);
-      }
+      FrameTransformation::MapParameters(&parameters_);
+      phase_vocoder_.Process(parameters_, input, output, size);
       break;
 
     case PLAYBACK_MODE_SPECTRAL_CLOUD:
@@ -189,9 +222,9 @@ void GranularProcessor::ProcessGranular(
           0.0f, // stereo_spread;
           0.0f, // feedback;
           0.0f, // reverb;
-          0.0f, // freeze;
-          parameters_.capture, // trigger;
-          0.0f // gate;
+          false, // freeze;
+          parameters_.capture, // capture;
+          false // gate;
         };
 
         if (resolution() == 8) {
@@ -328,7 +361,7 @@ void GranularProcessor::Process(
     ShortFrame* input,
     ShortFrame* output,
     size_t size) {
-  // TIC
+  uint32_t start_time = CycleCounter::Read();
   if (bypass_) {
     copy(&input[0], &input[size], &output[0]);
     return;
@@ -341,36 +374,39 @@ void GranularProcessor::Process(
     return;
   }
 
+#ifdef PROFILE_STAGES
+  profiler_.Start(playback_mode_, size);
+#endif  // PROFILE_STAGES
+
   // Convert input buffers to float, and mixdown for mono processing.
   // SUPERCELL Handle Mute In separately
-  // TODO[pld] These loops look inefficient, we should be able to avoid unnecesary float/short conversions
-  float mute_level_in;
-  for (size_t i = 0; i < size; i++) {
-    if (mute_out_) {
-        mute_level_in = 0.0f;
-    } else {
-        mute_level_in = mute_in_ ? 0.0f : 1.0f;
-    }
-    mute_in_fade_ += 0.01f * (mute_level_in - mute_in_fade_);
-    input[i].l = input[i].l * mute_in_fade_;
-    input[i].r = input[i].r * mute_in_fade_;
-  }
-  for (size_t i = 0; i < size; ++i) {
-    in_[i].l = static_cast<float>(input[i].l) / 32768.0f;
-    in_[i].r = static_cast<float>(input[i].r) / 32768.0f;
-  }
-
+  float mute_level_in = mute_out_ || mute_in_ ? 0.0f : 1.0f;
   if (num_channels_ == 1) {
-    for (size_t i = 0; i < size; ++i) {
-      float xfade = 0.5f;
-      // in mono delay modes, stereo spread controls input crossfade
-      if (playback_mode_ == PLAYBACK_MODE_LOOPING_DELAY ||
-          playback_mode_ == PLAYBACK_MODE_STRETCH)
-        xfade = parameters_.stereo_spread;
-
-      in_[i].l = in_[i].l * (1.0f - xfade) + in_[i].r * xfade;
-      in_[i].r = in_[i].l;
-    }
+    float xfade = 0.5f;
+    // in mono delay modes, stereo spread controls input crossfade
+    if (playback_mode_ == PLAYBACK_MODE_LOOPING_DELAY ||
+        playback_mode_ == PLAYBACK_MODE_STRETCH)
+      xfade = parameters_.stereo_spread;
+    ConvertInput<1>(input, in_, size, mute_level_in, &mute_in_fade_, xfade);
+  } else {
+    ConvertInput<2>(input, in_, size, mute_level_in, &mute_in_fade_, 0.0f);
+  }
+  PROFILE_STAGE(PROFILER_STAGE_INPUT);
+
+  // With decimated post-processing, everything from the feedback to the
+  // reverb runs at the decimated rate, and the output is upsampled once at the
+  // end.
+  const bool decimated_fx = low_fidelity_ && decimated_post_processing_;
+  const bool fixed_point_fx = low_fidelity_ && fixed_point_post_processing_;
+  FloatFrame* in = in_;
+  FloatFrame* out = out_;
+  size_t fx_size = size;
+  if (decimated_fx) {
+    fx_size = size / kDownsamplingFactor;
+    src_down_.Process(in_, in_downsampled_, size);
+    in = in_downsampled_;
+    out = out_downsampled_;
+    PROFILE_STAGE(PROFILER_STAGE_SRC_DOWN);
   }
 
   // Apply feedback, with high-pass filtering to prevent build-ups at very
@@ -388,24 +424,34 @@ void GranularProcessor::Process(
 	float cutoff = (20.0f + 100.0f * feedback * feedback) / sample_rate();
 	fb_filter_[0].set_f_q<FREQUENCY_FAST>(cutoff, 1.0f);
 	fb_filter_[1].set(fb_filter_[0]);
-	fb_filter_[0].Process<FILTER_MODE_HIGH_PASS>(&fb_[0].l, &fb_[0].l, size, 2);
-	fb_filter_[1].Process<FILTER_MODE_HIGH_PASS>(&fb_[0].r, &fb_[0].r, size, 2);
+	fb_filter_[0].Process<FILTER_MODE_HIGH_PASS>(
+	    &fb_[0].l, &fb_[0].l, fx_size, 2);
+	fb_filter_[1].Process<FILTER_MODE_HIGH_PASS>(
+	    &fb_[0].r, &fb_[0].r, fx_size, 2);
   }
   float fb_gain = feedback * (1.0f - freeze_lp_);
-  for (size_t i = 0; i < size; ++i) {
-	in_[i].l += fb_gain * (
-		SoftLimit(fb_gain * 1.4f * fb_[i].l + in_[i].l) - in_[i].l);
-	in_[i].r += fb_gain * (
-		SoftLimit(fb_gain * 1.4f * fb_[i].r + in_[i].r) - in_[i].r);
+  for (size_t i = 0; i < fx_size; ++i) {
+	in[i].l += fb_gain * (
+		SoftLimit(fb_gain * 1.4f * fb_[i].l + in[i].l) - in[i].l);
+	in[i].r += fb_gain * (
+		SoftLimit(fb_gain * 1.4f * fb_[i].r + in[i].r) - in[i].r);
   }
+  PROFILE_STAGE(PROFILER_STAGE_FEEDBACK);
 
-  if (low_fidelity_) {
+  if (decimated_fx) {
+    ProcessGranular(in, out, fx_size);
+    PROFILE_STAGE(PROFILER_STAGE_GRANULAR);
+  } else if (low_fidelity_) {
     size_t downsampled_size = size / kDownsamplingFactor;
     src_down_.Process(in_, in_downsampled_,size);
+    PROFILE_STAGE(PROFILER_STAGE_SRC_DOWN);
     ProcessGranular(in_downsampled_, out_downsampled_, downsampled_size);
+    PROFILE_STAGE(PROFILER_STAGE_GRANULAR);
     src_up_.Process(out_downsampled_, out_, downsampled_size);
+    PROFILE_STAGE(PROFILER_STAGE_SRC_UP);
   } else {
     ProcessGranular(in_, out_, size);
+    PROFILE_STAGE(PROFILER_STAGE_GRANULAR);
   }
 
   // Diffusion and pitch-shifting post-processings.
@@ -419,7 +465,9 @@ void GranularProcessor::Process(
         ? texture > 0.75f ? (texture - 0.75f) * 4.0f : 0.0f
         : parameters_.density;
     diffuser_.set_amount(diffusion);
-    diffuser_.Process(out_, size);
+    diffuser_.set_fixed_point(fixed_point_fx);
+    diffuser_.Process(out, fx_size);
+    PROFILE_STAGE(PROFILER_STAGE_DIFFUSER);
   }
 
   if (((playback_mode_ == PLAYBACK_MODE_LOOPING_DELAY)
@@ -443,7 +491,8 @@ void GranularProcessor::Process(
       // beat repeat
       pitch_shifter_.set_dry_wet(1.f);
     }
-    pitch_shifter_.Process(out_, size);
+    pitch_shifter_.Process(out, fx_size);
+    PROFILE_STAGE(PROFILER_STAGE_PITCH_SHIFTER);
   }
 
   // Apply filters.
@@ -454,64 +503,80 @@ void GranularProcessor::Process(
         (cutoff < 0.5f ? cutoff - 0.5f : 0.0f) * 216.0f);
     float hp_cutoff = 0.25f * SemitonesToRatio(
         (cutoff < 0.5f ? -0.5f : cutoff - 1.0f) * 216.0f);
+    if (decimated_fx) {
+      lp_cutoff *= kDownsamplingFactor;
+      hp_cutoff *= kDownsamplingFactor;
+    }
     CONSTRAIN(lp_cutoff, 0.0f, 0.499f);
     CONSTRAIN(hp_cutoff, 0.0f, 0.499f);
 
     lp_filter_[0].set_f_q<FREQUENCY_FAST>(lp_cutoff, 0.9f);
     lp_filter_[0].Process<FILTER_MODE_LOW_PASS>(
-        &out_[0].l, &out_[0].l, size, 2);
+        &out[0].l, &out[0].l, fx_size, 2);
 
     lp_filter_[1].set(lp_filter_[0]);
     lp_filter_[1].Process<FILTER_MODE_LOW_PASS>(
-        &out_[0].r, &out_[0].r, size, 2);
+        &out[0].r, &out[0].r, fx_size, 2);
 
     hp_filter_[0].set_f_q<FREQUENCY_FAST>(hp_cutoff, 0.9f);
     hp_filter_[0].Process<FILTER_MODE_HIGH_PASS>(
-        &out_[0].l, &out_[0].l, size, 2);
+        &out[0].l, &out[0].l, fx_size, 2);
 
     hp_filter_[1].set(hp_filter_[0]);
     hp_filter_[1].Process<FILTER_MODE_HIGH_PASS>(
-        &out_[0].r, &out_[0].r, size, 2);
-  }
-
-  // SUPERCELL Added Pre-Reverb Muting.
-  float mute_level_out;
-  for (size_t i = 0; i < size; i++) {
-      if (mute_out_) {
-        //mute_level_in = 0.0f;
-        mute_level_out = 0.0f;
-      } else {
-        mute_level_out = 1.0f;
-        //mute_level_in = mute_in_ ? 0.0f : 1.0f;
-      }
-      mute_out_fade_ += 0.01f * (mute_level_out - mute_out_fade_);
-      //mute_in_fade_ += 0.01f * (mute_level_in - mute_in_fade_);
-      out_[i].l = out_[i].l * mute_out_fade_;
-      out_[i].r = out_[i].r * mute_out_fade_;
-      //input[i].l = input[i].l * mute_in_fade_;
-      //input[i].r = input[i].r * mute_in_fade_;
+        &out[0].r, &out[0].r, fx_size, 2);
+    PROFILE_STAGE(PROFILER_STAGE_FILTERS);
   }
-  
-  // This is what is fed back. Reverb is not fed back.
-  copy(&out_[0], &out_[size], &fb_[0]);
-
-  const float post_gain = 1.2f;
 
+  // SUPERCELL Added Pre-Reverb Muting. The muted signal is what is fed back
+  // (reverb is not fed back), then it is mixed with the dry signal.
+  float mute_level_out = mute_out_ ? 0.0f : 1.0f;
   if (playback_mode_ != PLAYBACK_MODE_RESONESTOR) {
-    ParameterInterpolator dry_wet_mod(&dry_wet_, parameters_.dry_wet, size);
+    const float post_gain = 1.2f;
+    const bool kammerl = playback_mode_ == PLAYBACK_MODE_KAMMERL;
+    ParameterInterpolator dry_wet_mod(
+        &dry_wet_, parameters_.dry_wet, fx_size);
+    const ShortFrame* dry_input = input;
+    if (dry_delay_size_) {
+      DelayDry(input, dry_, size);
+      dry_input = dry_;
+    }
+    // The dry signal, at the rate of the effects. The input buffers have been
+    // consumed and are reused.
+    FloatFrame* dry = in_;
     for (size_t i = 0; i < size; ++i) {
+      dry[i].l = static_cast<float>(dry_input[i].l) / 32768.0f;
+      dry[i].r = static_cast<float>(dry_input[i].r) / 32768.0f;
+    }
+    if (decimated_fx) {
+      src_dry_down_.Process(in_, in_downsampled_, size);
+      dry = in_downsampled_;
+    }
+    for (size_t i = 0; i < fx_size; ++i) {
+      mute_out_fade_ = MuteFadeStep(mute_out_fade_, mute_level_out);
+      float wet_l = out[i].l * mute_out_fade_;
+      float wet_r = out[i].r * mute_out_fade_;
+      fb_[i].l = wet_l;
+      fb_[i].r = wet_r;
+
       float dry_wet = dry_wet_mod.Next();
-      if (playback_mode_ == PLAYBACK_MODE_KAMMERL) {
+      if (kammerl) {
         dry_wet = 1.0f;
       }
       float fade_in = Interpolate(lut_xfade_in, dry_wet, 16.0f);
       float fade_out = Interpolate(lut_xfade_out, dry_wet, 16.0f);
-      float l = static_cast<float>(input[i].l) / 32768.0f;
-      float r = static_cast<float>(input[i].r) / 32768.0f;
-      out_[i].l = l * fade_out + out_[i].l * post_gain * fade_in;
-      out_[i].r = r * fade_out + out_[i].r * post_gain * fade_in;
+      out[i].l = dry[i].l * fade_out + wet_l * post_gain * fade_in;
+      out[i].r = dry[i].r * fade_out + wet_r * post_gain * fade_in;
+    }
+  } else {
+    for (size_t i = 0; i < fx_size; ++i) {
+      mute_out_fade_ = MuteFadeStep(mute_out_fade_, mute_level_out);
+      out[i].l *= mute_out_fade_;
+      out[i].r *= mute_out_fade_;
+      fb_[i] = out[i];
     }
   }
+  PROFILE_STAGE(PROFILER_STAGE_DRY_WET);
 
   // Apply the simple post-processing reverb.
   if (playback_mode_ != PLAYBACK_MODE_OLIVERB &&
@@ -521,24 +586,45 @@ void GranularProcessor::Process(
 
     reverb_.set_amount(reverb_amount * 0.54f);
     reverb_.set_diffusion(0.7f);
-    reverb_.set_time(0.35f + 0.63f * reverb_amount);
+    float reverb_time = 0.35f + 0.63f * reverb_amount;
+    float reverb_lp = 0.6f + 0.37f * feedback;
+    if (decimated_fx) {
+      // Same decay time and damping with half as many passes in the loop.
+      reverb_time *= reverb_time;
+      reverb_lp = 1.0f - (1.0f - reverb_lp) * (1.0f - reverb_lp);
+    }
+    reverb_.set_time(reverb_time);
     reverb_.set_input_gain(0.2f);
-    reverb_.set_lp(0.6f + 0.37f * feedback);
+    reverb_.set_lp(reverb_lp);
+    reverb_.set_fixed_point(fixed_point_fx);
 
-    reverb_.Process(out_, size);
+    reverb_.Process(out, fx_size);
+    PROFILE_STAGE(PROFILER_STAGE_REVERB);
   }
 
-  for (size_t i = 0; i < size; ++i) {
-    if (playback_mode_ == PLAYBACK_MODE_SPECTRAL_CLOUD) {
-	    WarmDistortion(&out_[i].l, parameters_.kammerl.pitch_mode);
-	    WarmDistortion(&out_[i].r, parameters_.kammerl.pitch_mode);
+  if (playback_mode_ == PLAYBACK_MODE_SPECTRAL_CLOUD) {
+    for (size_t i = 0; i < fx_size; ++i) {
+	    WarmDistortion(&out[i].l, parameters_.kammerl.pitch_mode);
+	    WarmDistortion(&out[i].r, parameters_.kammerl.pitch_mode);
     }
-
-    output[i].l = SoftConvert(out_[i].l);
-    output[i].r = SoftConvert(out_[i].r);
   }
-
-  // TOC
+  if (decimated_fx) {
+    src_up_.Process(out_downsampled_, out_, fx_size);
+    PROFILE_STAGE(PROFILER_STAGE_SRC_UP);
+  }
+  SoftConvertBlock(out_, output, size);
+  PROFILE_STAGE(PROFILER_STAGE_OUTPUT);
+
+#ifdef PROFILE_STAGES
+  profiler_.End();
+#endif  // PROFILE_STAGES
+
+  if (adaptive_grains_ && playback_mode_ == PLAYBACK_MODE_GRANULAR) {
+    const uint32_t kTicksPerSample = CycleCounter::kTicksPerSecond / 32000;
+    grain_scheduler_.Update(
+        CycleCounter::Read() - start_time,
+        kTicksPerSample * size);
+  }
 }
 
 void GranularProcessor::PreparePersistentData() {
@@ -547,11 +633,23 @@ void GranularProcessor::PreparePersistentData() {
   persistent_state_.write_head[1] = low_fidelity_ ?
       buffer_8_[1].head() : buffer_16_[1].head();
   persistent_state_.quality = quality();
+  persistent_state_.spectral_fft_size = spectral_fft_size_ >> 8;
+  persistent_state_.spectral_hop_ratio = spectral_hop_ratio_;
+  persistent_state_.spectral_texture_format = spectral_texture_format_;
   if (playback_mode_ == PLAYBACK_MODE_SPECTRAL ||
-      playback_mode_ == PLAYBACK_MODE_SPECTRAL_CLOUD)
+      playback_mode_ == PLAYBACK_MODE_SPECTRAL_CLOUD) {
     persistent_state_.spectral = playback_mode_;
-  else
+    // Until ReleasePersistentData() is called, the spectral state is unusable.
+    phase_vocoder_.PackSnapshots();
+  } else {
     persistent_state_.spectral = 0;
+  }
+}
+
+void GranularProcessor::ReleasePersistentData() {
+  if (persistent_state_.spectral) {
+    phase_vocoder_.UnpackSnapshots();
+  }
 }
 
 void GranularProcessor::GetPersistentData(
@@ -563,12 +661,23 @@ void GranularProcessor::GetPersistentData(
   block->size = sizeof(PersistentState);
   ++block;
 
-  // Create save block holding the audio buffers.
-  for (int32_t i = 0; i < num_channels_; ++i) {
-    block->tag = FourCC<'b', 'u', 'f', 'f'>::value;
-    block->data = buffer_[i];
-    block->size = buffer_size_[num_channels_ - 1];
-    ++block;
+  if (spectral()) {
+    // The spectral modes only save what they need to resume a frozen sound.
+    for (int32_t i = 0; i < num_channels_; ++i) {
+      size_t size;
+      block->tag = FourCC<'s', 'p', 'e', 'c'>::value;
+      block->data = phase_vocoder_.snapshot(i, &size);
+      block->size = size;
+      ++block;
+    }
+  } else {
+    // Create save block holding the audio buffers.
+    for (int32_t i = 0; i < num_channels_; ++i) {
+      block->tag = FourCC<'b', 'u', 'f', 'f'>::value;
+      block->data = buffer_[i];
+      block->size = buffer_size_[num_channels_ - 1];
+      ++block;
+    }
   }
   *num_blocks = block - first_block;
 }
@@ -607,15 +716,43 @@ bool GranularProcessor::LoadPersistentData(const uint32_t* data) {
             : PLAYBACK_MODE_GRANULAR);
       }
       set_quality(persistent_state_.quality);
+      // The layout of the spectral textures depends on the FFT size. Older
+      // saves do not record it, and were made with the default settings.
+      set_spectral_fft_size(persistent_state_.spectral_fft_size
+          ? persistent_state_.spectral_fft_size << 8
+          : kMaxFftSize);
+      set_spectral_hop_ratio(persistent_state_.spectral_hop_ratio
+          ? persistent_state_.spectral_hop_ratio
+          : 4);
+      set_spectral_texture_format(
+          persistent_state_.spectral_texture_format < TEXTURE_FORMAT_LAST
+          ? static_cast<TextureFormat>(
+              persistent_state_.spectral_texture_format)
+          : TEXTURE_FORMAT_FLOAT);
 
       // We can force a switch to this mode, and once everything has been
       // initialized for this mode, we continue with the loop to copy the
       // actual buffer data - with all state variables correctly initialized.
       Prepare();
       GetPersistentData(block, &num_blocks);
+
+      // Check the other blocks before copying any of them, so that a bad
+      // save does not leave the buffers or spectral state half-loaded.
+      const uint32_t* next = data;
+      for (size_t j = 1; j < num_blocks; ++j) {
+        if (block[j].tag != next[0] || block[j].size != next[1]) {
+          silence_ = false;
+          return false;
+        }
+        next += 2 + block[j].size / sizeof(uint32_t);
+      }
     }
   }
 
+  if (spectral()) {
+    phase_vocoder_.UnpackSnapshots();
+  }
+
   // We can finally reset the position of the write heads.
   if (low_fidelity_) {
     buffer_8_[0].Resync(persistent_state_.write_head[0]);
@@ -682,7 +819,7 @@ void GranularProcessor::Prepare() {
 
     uint16_t* reverb_buffer = allocator.Allocate<uint16_t>(16384);
     if (playback_mode_ == PLAYBACK_MODE_OLIVERB) {
-      oliverb_.Init(reverb_buffer);
+      oliverb_.Init(reverb_buffer, &random_);
     } else {
       reverb_.Init(reverb_buffer);
     }
@@ -695,21 +832,57 @@ void GranularProcessor::Prepare() {
         &correlator_data[correlator_block_size]);
     pitch_shifter_.Init((uint16_t*)correlator_data);
 
+    // The dry delay lines are taken from what is left of the workspace, or
+    // else from the end of the spectral buffers (the first one in mono) if
+    // the phase vocoder still fits. Otherwise, the dry signal is not delayed.
+    // With decimated post-processing, the dry signal goes through the sample
+    // rate conversions too.
+    dry_delay_size_ = spectral() && dry_delay_ ? latency() : 0;
+    if (dry_delay_size_ && low_fidelity_ && decimated_post_processing_) {
+      dry_delay_size_ -= kDownsamplingLatency;
+    }
+    dry_delay_ptr_ = 0;
+    if (dry_delay_size_) {
+      size_t line_size = ((dry_delay_size_ + 1) & ~1) * sizeof(int16_t);
+      size_t min_size = PhaseVocoder::min_buffer_size(
+          spectral_fft_size_, num_channels_);
+      size_t spectral_buffer_size[2] = { buffer_size[0], buffer_size[1] };
+      for (int32_t i = 0; i < 2; ++i) {
+        int32_t channel = num_channels_ == 1 ? 0 : i;
+        dry_delay_line_[i] = allocator.Allocate<int16_t>(line_size >> 1);
+        if (!dry_delay_line_[i] &&
+            buffer_size[channel] >= min_size + line_size) {
+          buffer_size[channel] -= line_size;
+          dry_delay_line_[i] = static_cast<int16_t*>(static_cast<void*>(
+              static_cast<uint8_t*>(buffer[channel]) + buffer_size[channel]));
+        }
+        if (!dry_delay_line_[i]) {
+          buffer_size[0] = spectral_buffer_size[0];
+          buffer_size[1] = spectral_buffer_size[1];
+          dry_delay_size_ = 0;
+          break;
+        }
+        fill(&dry_delay_line_[i][0], &dry_delay_line_[i][dry_delay_size_], 0);
+      }
+    }
+
+    phase_vocoder_.set_paired_transforms(paired_transforms_);
     if (playback_mode_ == PLAYBACK_MODE_SPECTRAL) {
+      phase_vocoder_.set_texture_format(spectral_texture_format_);
       phase_vocoder_.Init(
           PhaseVocoder::TRANSFORMATION_TYPE_FRAME,
           buffer, buffer_size,
-          lut_sine_window_4096, 4096,
-          num_channels_, resolution(), sr);
+          lut_sine_window_4096, spectral_fft_size_, spectral_hop_ratio_,
+          num_channels_, resolution(), sr, &random_);
     } else if (playback_mode_ == PLAYBACK_MODE_SPECTRAL_CLOUD) {
       phase_vocoder_.Init(
           PhaseVocoder::TRANSFORMATION_TYPE_SPECTRAL_CLOUD,
           buffer, buffer_size,
-          lut_sine_window_4096, 4096,
-          num_channels_, resolution(), sr);
+          lut_sine_window_4096, spectral_fft_size_, spectral_hop_ratio_,
+          num_channels_, resolution(), sr, &random_);
     } else if (playback_mode_ == PLAYBACK_MODE_RESONESTOR) {
       float* buf = (float*)buffer[0];
-      resonestor_.Init(buf);
+      resonestor_.Init(buf, &random_);
     } else {
       for (int32_t i = 0; i < num_channels_; ++i) {
         if (resolution() == 8) {
@@ -726,10 +899,11 @@ void GranularProcessor::Prepare() {
       }
       int32_t num_grains = (num_channels_ == 1 ? 32 : 26) * \
           (low_fidelity_ ? 20 : 16) >> 4;
-      player_.Init(num_channels_, num_grains);
+      grain_scheduler_.Init(num_grains);
+      player_.Init(num_channels_, &grain_scheduler_, &random_);
       ws_player_.Init(&correlator_, num_channels_);
       looper_.Init(num_channels_);
-      kammerl_.Init(num_channels_);
+      kammerl_.Init(num_channels_, &random_);
     }
     reset_buffers_ = false;
     previous_playback_mode_ = playback_mode_;
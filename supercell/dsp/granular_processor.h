@@ -34,6 +34,7 @@
 
 #include "supercell/dsp/correlator.h"
 #include "supercell/dsp/frame.h"
+#include "supercell/dsp/grain_scheduler.h"
 #include "supercell/dsp/fx/diffuser.h"
 #include "supercell/dsp/fx/pitch_shifter.h"
 #include "supercell/dsp/fx/reverb.h"
@@ -44,12 +45,31 @@
 #include "supercell/dsp/kammerl_player.h"
 #include "supercell/dsp/looping_sample_player.h"
 #include "supercell/dsp/pvoc/phase_vocoder.h"
+#include "supercell/dsp/profiler.h"
+#include "supercell/dsp/random_generator.h"
 #include "supercell/dsp/sample_rate_converter.h"
 #include "supercell/dsp/wsola_sample_player.h"
 
 namespace clouds {
 
 const int32_t kDownsamplingFactor = 2;
+const int32_t kMinSpectralFftSize = 1024;
+const int32_t kMinSpectralHopRatio = 2;
+const int32_t kMaxSpectralHopRatio = 8;
+
+// Number of taps of the anti-aliasing filter of the 2:1 sample rate
+// conversion of the low-fidelity modes: 31, 45, 63 or 91. Longer filters have
+// a narrower transition band, more latency and cost more.
+#ifndef CLOUDS_SRC_FILTER_SIZE
+  #define CLOUDS_SRC_FILTER_SIZE 45
+#endif  // CLOUDS_SRC_FILTER_SIZE
+
+#define CLOUDS_SRC_FILTER_2(size) src_filter_1x_2_ ## size
+#define CLOUDS_SRC_FILTER(size) CLOUDS_SRC_FILTER_2(size)
+
+// Delay of the 2:1 sample rate conversion of the low-fidelity modes: half the
+// filter at each rate, minus the sample skipped by the decimation.
+const int32_t kDownsamplingLatency = CLOUDS_SRC_FILTER_SIZE - 2;
 
 enum PlaybackMode {
   PLAYBACK_MODE_GRANULAR,
@@ -68,6 +88,9 @@ struct PersistentState {
   int32_t write_head[2];
   uint8_t quality;
   uint8_t spectral;
+  uint8_t spectral_fft_size;  // In units of 256 samples, 0 if not saved.
+  uint8_t spectral_hop_ratio : 4;  // 0 if not saved.
+  uint8_t spectral_texture_format : 4;
 };
 
 // Data block as saved in one of the 4 sample memories.
@@ -169,6 +192,82 @@ class GranularProcessor {
     low_fidelity_ = low_fidelity;
   }
   
+  // FFT size (1024, 2048 or 4096) and overlap (2, 4 or 8) of the spectral
+  // modes. A smaller FFT has less latency, uses less CPU and leaves memory for
+  // more textures; more overlap sounds smoother and costs more CPU.
+  inline void set_spectral_fft_size(int32_t fft_size) {
+    CONSTRAIN(fft_size, kMinSpectralFftSize, int32_t(kMaxFftSize));
+    while (fft_size & (fft_size - 1)) {
+      fft_size &= fft_size - 1;
+    }
+    reset_buffers_ = reset_buffers_ || \
+        (spectral_fft_size_ != fft_size && spectral());
+    spectral_fft_size_ = fft_size;
+  }
+
+  inline void set_spectral_hop_ratio(int32_t hop_ratio) {
+    CONSTRAIN(hop_ratio, kMinSpectralHopRatio, kMaxSpectralHopRatio);
+    while (hop_ratio & (hop_ratio - 1)) {
+      hop_ratio &= hop_ratio - 1;
+    }
+    reset_buffers_ = reset_buffers_ || \
+        (spectral_hop_ratio_ != hop_ratio && spectral());
+    spectral_hop_ratio_ = hop_ratio;
+  }
+
+  // Storage of the magnitudes recorded by the spectral mode. The compressed
+  // formats give 2 or 4 times more textures, hence a finer POSITION, at the
+  // cost of precision.
+  inline void set_spectral_texture_format(TextureFormat texture_format) {
+    reset_buffers_ = reset_buffers_ || \
+        (spectral_texture_format_ != texture_format &&
+         playback_mode_ == PLAYBACK_MODE_SPECTRAL);
+    spectral_texture_format_ = texture_format;
+  }
+
+  // When enabled, the dry signal of the spectral modes is delayed by
+  // latency(), so that a mix of the dry and wet signals does not comb filter.
+  // The delay line takes the place of some of the textures, and is left out
+  // when there is not enough memory for it (see dry_delay_size()).
+  inline void set_dry_delay(bool dry_delay) {
+    reset_buffers_ = reset_buffers_ || (dry_delay_ != dry_delay && spectral());
+    dry_delay_ = dry_delay;
+  }
+
+  inline bool dry_delay() const { return dry_delay_; }
+
+  // When enabled, the spectral modes transform the two channels of the
+  // stereo qualities together, with one complex FFT and IFFT per hop rather
+  // than two real ones (see PhaseVocoder::set_paired_transforms()). The
+  // output differs slightly from the separate transforms.
+  inline void set_paired_transforms(bool paired_transforms) {
+    reset_buffers_ = reset_buffers_ || \
+        (paired_transforms_ != paired_transforms && spectral());
+    paired_transforms_ = paired_transforms;
+  }
+
+  inline bool paired_transforms() const { return paired_transforms_; }
+  inline int32_t dry_delay_size() const { return dry_delay_size_; }
+
+  // Delay of the wet signal, in samples: fft size + hop size in the spectral
+  // modes, doubled at low fidelity, plus the delay of the sample rate
+  // conversion. The delay of the other modes depends on their parameters;
+  // only the sample rate conversion is counted.
+  inline int32_t latency() const {
+    int32_t latency = spectral()
+        ? spectral_fft_size_ + spectral_fft_size_ / spectral_hop_ratio_
+        : 0;
+    return low_fidelity_
+        ? latency * kDownsamplingFactor + kDownsamplingLatency
+        : latency;
+  }
+
+  inline int32_t spectral_fft_size() const { return spectral_fft_size_; }
+  inline int32_t spectral_hop_ratio() const { return spectral_hop_ratio_; }
+  inline TextureFormat spectral_texture_format() const {
+    return spectral_texture_format_;
+  }
+
   inline int32_t quality() const {
     int32_t quality = 0;
     if (num_channels_ == 1) quality |= 1;
@@ -176,13 +275,79 @@ class GranularProcessor {
     return quality;
   }
   
+  // Restarts the random sequence used by the players and effects. Two
+  // processors seeded identically and fed the same input and parameters
+  // render the same output.
+  inline void Seed(uint32_t seed) {
+    random_.Seed(seed);
+  }
+
+  // When enabled, the polyphony and quality of the granular mode follow the
+  // measured processing time (see GrainScheduler). Disabled by default, since
+  // the output then depends on the speed of the machine.
+  inline void set_adaptive_grains(bool adaptive_grains) {
+    adaptive_grains_ = adaptive_grains;
+  }
+
+  // Maximum time spent in the STFT of the spectral modes by a call to
+  // Prepare(), in CycleCounter ticks. The work left is resumed by the next
+  // call. With 0 (the default), each call processes a full hop.
+  inline void set_prepare_time_budget(uint32_t ticks) {
+    phase_vocoder_.set_time_budget(ticks);
+  }
+
+  // When enabled, the post-processing (diffuser, pitch shifter, filters,
+  // dry/wet mix and reverb) of the low fidelity qualities runs at the
+  // decimated rate, with a single upsampling at the output. This halves its
+  // cost, but the dry signal is band-limited as well, and the delays of the
+  // effects are twice as long.
+  inline void set_decimated_post_processing(bool decimated_post_processing) {
+    reset_buffers_ = reset_buffers_ || (low_fidelity_ &&
+        decimated_post_processing_ != decimated_post_processing);
+    decimated_post_processing_ = decimated_post_processing;
+  }
+
+  inline bool decimated_post_processing() const {
+    return decimated_post_processing_;
+  }
+
+  // When enabled, the diffuser and reverb of the low fidelity qualities run
+  // on 12-bit integers rather than floats. Disabled by default: the output
+  // differs slightly from the float effects.
+  inline void set_fixed_point_post_processing(bool fixed_point) {
+    fixed_point_post_processing_ = fixed_point;
+  }
+
+  inline bool fixed_point_post_processing() const {
+    return fixed_point_post_processing_;
+  }
+
+  inline const GrainScheduler& grain_scheduler() const {
+    return grain_scheduler_;
+  }
+
+  // A save calls PreparePersistentData(), writes the blocks listed by
+  // GetPersistentData(), then calls ReleasePersistentData(), which restores
+  // the state that PreparePersistentData() may have packed in place.
   void GetPersistentData(PersistentBlock* block, size_t *num_blocks);
   bool LoadPersistentData(const uint32_t* data);
   void PreparePersistentData();
+  void ReleasePersistentData();
+
+#ifdef PROFILE_STAGES
+  inline Profiler* mutable_profiler() {
+    return &profiler_;
+  }
+#endif  // PROFILE_STAGES
 
  private:
   void WarmDistortion(float* in, float parameter);
 
+  inline bool spectral() const {
+    return playback_mode_ == PLAYBACK_MODE_SPECTRAL ||
+        playback_mode_ == PLAYBACK_MODE_SPECTRAL_CLOUD;
+  }
+
   inline int32_t resolution() const {
     return low_fidelity_ ? 8 : 16;
   }
@@ -193,18 +358,27 @@ class GranularProcessor {
   }
      
   void ResetFilters();
+  void DelayDry(const ShortFrame* input, ShortFrame* output, size_t size);
   void ProcessGranular(FloatFrame* input, FloatFrame* output, size_t size);
 
   PlaybackMode playback_mode_;
   PlaybackMode previous_playback_mode_;
   int32_t num_channels_;
   bool low_fidelity_;
+  int32_t spectral_fft_size_;
+  int32_t spectral_hop_ratio_;
+  TextureFormat spectral_texture_format_;
   
   bool silence_;
   bool bypass_;
   bool reset_buffers_;
   bool mute_in_;
   bool mute_out_;
+  bool adaptive_grains_;
+  bool decimated_post_processing_;
+  bool fixed_point_post_processing_;
+  bool paired_transforms_;
+  bool dry_delay_;
   float mute_in_fade_;
   float mute_out_fade_;
 
@@ -216,6 +390,7 @@ class GranularProcessor {
   
   Correlator correlator_;
   
+  GrainScheduler grain_scheduler_;
   GranularSamplePlayer player_;
   WSOLASamplePlayer ws_player_;
   LoopingSamplePlayer looper_;
@@ -241,13 +416,33 @@ class GranularProcessor {
   FloatFrame fb_[kMaxBlockSize];
   
   int16_t tail_buffer_[2][256];
+
+  // Dry signal delay line of the spectral modes, one channel per line.
+  int16_t* dry_delay_line_[2];
+  int32_t dry_delay_size_;  // 0 when not delayed.
+  int32_t dry_delay_ptr_;
+  ShortFrame dry_[kMaxBlockSize];
   
   Parameters parameters_;
+  RandomGenerator random_;
   
-  SampleRateConverter<-kDownsamplingFactor, 45, src_filter_1x_2_45> src_down_;
-  SampleRateConverter<+kDownsamplingFactor, 45, src_filter_1x_2_45> src_up_;
+  typedef SampleRateConverter<
+      -kDownsamplingFactor,
+      CLOUDS_SRC_FILTER_SIZE,
+      CLOUDS_SRC_FILTER(CLOUDS_SRC_FILTER_SIZE)> Downsampler;
+  typedef SampleRateConverter<
+      +kDownsamplingFactor,
+      CLOUDS_SRC_FILTER_SIZE,
+      CLOUDS_SRC_FILTER(CLOUDS_SRC_FILTER_SIZE)> Upsampler;
+  Downsampler src_down_;
+  Upsampler src_up_;
+  Downsampler src_dry_down_;
   
   PersistentState persistent_state_;
+
+#ifdef PROFILE_STAGES
+  Profiler profiler_;
+#endif  // PROFILE_STAGES
   
   DISALLOW_COPY_AND_ASSIGN(GranularProcessor);
 };
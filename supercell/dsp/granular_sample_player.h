@@ -35,19 +35,18 @@
 
 #include "stmlib/dsp/atan.h"
 #include "stmlib/dsp/units.h"
-#include "stmlib/utils/random.h"
 
 #include "supercell/dsp/audio_buffer.h"
 #include "supercell/dsp/frame.h"
 #include "supercell/dsp/grain.h"
+#include "supercell/dsp/grain_scheduler.h"
 #include "supercell/dsp/parameters.h"
+#include "supercell/dsp/random_generator.h"
 
 #include "supercell/resources.h"
 
 namespace clouds {
 
-const int32_t kMaxNumGrains = 40;
-
 using namespace stmlib;
 
 class GranularSamplePlayer {
@@ -55,9 +54,12 @@ class GranularSamplePlayer {
   GranularSamplePlayer() { }
   ~GranularSamplePlayer() { }
   
-  void Init(int32_t num_channels, int32_t max_num_grains) {
-    max_num_grains_ = max_num_grains;
-    num_midfi_grains_ = 3 * max_num_grains / 4;
+  void Init(
+      int32_t num_channels,
+      const GrainScheduler* scheduler,
+      RandomGenerator* random) {
+    scheduler_ = scheduler;
+    random_ = random;
     gain_normalization_ = 1.0f;
     for (int32_t i = 0; i < kMaxNumGrains; ++i) {
       grains_[i].Init();
@@ -74,35 +76,46 @@ class GranularSamplePlayer {
       float* out, size_t size) {
     float overlap = parameters.granular.overlap;
     overlap = (overlap * overlap) * (overlap * overlap);
-    float target_num_grains = max_num_grains_ * overlap;
+    int32_t max_num_grains = scheduler_->num_grains();
+    int32_t num_midfi_grains = 3 * max_num_grains / 4;
+    GrainQuality max_quality = scheduler_->max_quality();
+    float target_num_grains = max_num_grains * overlap;
     float p = target_num_grains / static_cast<float>(grain_size_hint_);
     float space_between_grains = grain_size_hint_ / target_num_grains;
     if (parameters.granular.use_deterministic_seed) {
       p = -1.0f;
     } else {
       grain_rate_phasor_ = -1000.0f;
+      random_->FillFloats(seed_random_, size);
     }
     
     // Build a list of available grains.
-    int32_t num_available_grains = FillAvailableGrainsList();
+    int32_t num_active_grains = 0;
+    int32_t num_available_grains = FillAvailableGrainsList(
+        max_num_grains, &num_active_grains);
+    if (scheduler_->hold()) {
+      num_available_grains = 0;
+    }
     
     // Try to schedule new grains.
     bool seed_trigger = parameters.capture;
     for (size_t t = 0; t < size; ++t) {
       grain_rate_phasor_ += 1.0f;
-      bool seed_probabilistic = Random::GetFloat() < p
+      bool seed_probabilistic = p > 0.0f && seed_random_[t] < p
           && target_num_grains > num_grains_;
       bool seed_deterministic = grain_rate_phasor_ >= space_between_grains;
       bool seed = seed_probabilistic || seed_deterministic || seed_trigger;
       if (num_available_grains && seed) {
         --num_available_grains;
+        ++num_active_grains;
         int32_t index = available_grains_[num_available_grains];
         GrainQuality quality;
-        if (num_available_grains < num_midfi_grains_) {
+        if (num_available_grains < num_midfi_grains) {
           quality = GRAIN_QUALITY_MEDIUM;
         } else {
           quality = GRAIN_QUALITY_HIGH;
         }
+        quality = std::min(quality, max_quality);
         
         Grain* g = &grains_[index];
         ScheduleGrain(
@@ -120,7 +133,7 @@ class GranularSamplePlayer {
     // Overlap grains.
     std::fill(&out[0], &out[size * 2], 0.0f);
     float* e = envelope_buffer_;
-    for (int32_t i = 0; i < max_num_grains_; ++i) {
+    for (int32_t i = 0; i < kMaxNumGrains; ++i) {
       Grain* g = &grains_[i];
       if (g->recommended_quality() == GRAIN_QUALITY_HIGH) {
         if (num_channels_ == 1) {
@@ -144,8 +157,7 @@ class GranularSamplePlayer {
     }
     
     // Compute normalization factor.
-    int32_t active_grains = max_num_grains_ - num_available_grains;
-    SLOPE(num_grains_, static_cast<float>(active_grains), 0.9f, 0.2f);
+    SLOPE(num_grains_, static_cast<float>(num_active_grains), 0.9f, 0.2f);
 
     float gain_normalization = num_grains_ > 2.0f
         ? fast_rsqrt_carmack(num_grains_ - 1.0f)
@@ -164,15 +176,25 @@ class GranularSamplePlayer {
   }
   
  private:
-  int32_t FillAvailableGrainsList() {
+  // When the scheduler lowers the polyphony, grains above the new limit keep
+  // playing until they end, and count against it.
+  int32_t FillAvailableGrainsList(
+      int32_t max_num_grains,
+      int32_t* num_active_grains) {
     int32_t num_available_grains = 0;
-    for (int32_t i = 0; i < max_num_grains_; ++i) {
-      if (!grains_[i].active()) {
+    int32_t num_active = 0;
+    for (int32_t i = 0; i < kMaxNumGrains; ++i) {
+      if (grains_[i].active()) {
+        ++num_active;
+      } else if (i < max_num_grains) {
         available_grains_[num_available_grains] = i;
         ++num_available_grains;
       }
     }
-    return num_available_grains;
+    *num_active_grains = num_active;
+    return std::min(
+        num_available_grains,
+        std::max(max_num_grains - num_active, 0));
   }
   
   void ScheduleGrain(
@@ -188,7 +210,7 @@ class GranularSamplePlayer {
     float grain_size = Interpolate(lut_grain_size, parameters.size, 256.0f);
     float pitch_ratio = SemitonesToRatio(pitch);
     float inv_pitch_ratio = SemitonesToRatio(-pitch);
-    float pan = 0.5f + parameters.stereo_spread * (Random::GetFloat() - 0.5f);
+    float pan = 0.5f + parameters.stereo_spread * (random_->GetFloat() - 0.5f);
     float gain_l, gain_r;
     if (num_channels_ == 1) {
       gain_l = Interpolate(lut_sin, pan, 256.0f);
@@ -237,8 +259,6 @@ class GranularSamplePlayer {
     grain_size_hint_ = grain_size;
   }
   
-  int32_t max_num_grains_;
-  int32_t num_midfi_grains_;
   int32_t num_channels_;
 
   float num_grains_;
@@ -249,6 +269,10 @@ class GranularSamplePlayer {
   Grain grains_[kMaxNumGrains];
   int32_t available_grains_[kMaxNumGrains];
   float envelope_buffer_[kMaxBlockSize];
+  float seed_random_[kMaxBlockSize];
+
+  const GrainScheduler* scheduler_;
+  RandomGenerator* random_;
   
   DISALLOW_COPY_AND_ASSIGN(GranularSamplePlayer);
 };
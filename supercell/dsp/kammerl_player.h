@@ -37,11 +37,11 @@
 
 #include "stmlib/dsp/units.h"
 #include "stmlib/stmlib.h"
-#include "stmlib/utils/random.h"
 
 #include "supercell/dsp/audio_buffer.h"
 #include "supercell/dsp/frame.h"
 #include "supercell/dsp/parameters.h"
+#include "supercell/dsp/random_generator.h"
 
 #include "supercell/resources.h"
 
@@ -86,8 +86,9 @@ public:
 	~KammerlPlayer() {
 	}
 
-	void Init(int32_t num_channels) {
+	void Init(int32_t num_channels, RandomGenerator* random) {
 		num_channels_ = num_channels;
+		random_ = random;
 		num_samples_since_trigger_ = 0;
 		slice_buffer_pos_index_ = 0;
 		slice_play_pos_samples_ = 0.0f;
@@ -139,7 +140,7 @@ public:
 			break;
 		default:
 		case RANDOM_STEP:
-			slice_step += stmlib::Random::GetFloat() * (kNumMaxSlices - 1)
+			slice_step += random_->GetFloat() * (kNumMaxSlices - 1)
 					+ 0.5;
 			break;
 		}
@@ -163,7 +164,7 @@ public:
 
 			const bool slice_still_playing = num_remaining_samples_in_slice_
 					> latest_trigger_interval_samples / 2;
-			const float rand_percentage = stmlib::Random::GetFloat();
+			const float rand_percentage = random_->GetFloat();
 			const bool trigger_slice = !slice_still_playing
 					&& ((rand_percentage < parameters.kammerl.probability)
 							|| parameters.freeze
@@ -374,6 +375,8 @@ private:
 	int32_t num_channels_;
 	int32_t num_samples_since_trigger_;
 
+	RandomGenerator* random_;
+
 	// Currently active playback mode.
 	PlaybackModes playback_mode_;
 
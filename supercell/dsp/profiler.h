@@ -0,0 +1,210 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Per-stage profiler for GranularProcessor::Process().
+//
+// Only compiled in when PROFILE_STAGES is defined (make PROFILE_STAGES=TRUE).
+// The audio interrupt timestamps the stages of a block with the cycle counter
+// and pushes one record per block in a small ring buffer; all the statistics
+// (min/avg/max and a histogram relative to the block's real-time budget) are
+// computed by Poll(), called from the main loop or by the host tools. The
+// statistics are restarted whenever the playback mode changes, so that they
+// always describe a single mode.
+
+#ifndef CLOUDS_DSP_PROFILER_H_
+#define CLOUDS_DSP_PROFILER_H_
+
+#include "stmlib/stmlib.h"
+
+#include <algorithm>
+
+#include "supercell/drivers/cycle_counter.h"
+
+namespace clouds {
+
+enum ProfilerStage {
+  PROFILER_STAGE_INPUT,  // Mute in, conversion to float, mono mixdown.
+  PROFILER_STAGE_FEEDBACK,
+  PROFILER_STAGE_SRC_DOWN,
+  PROFILER_STAGE_GRANULAR,  // ProcessGranular() for the current mode.
+  PROFILER_STAGE_SRC_UP,
+  PROFILER_STAGE_DIFFUSER,
+  PROFILER_STAGE_PITCH_SHIFTER,
+  PROFILER_STAGE_FILTERS,
+  PROFILER_STAGE_DRY_WET,  // Mute out, feedback copy, dry/wet mix.
+  PROFILER_STAGE_REVERB,
+  PROFILER_STAGE_OUTPUT,  // Distortion and conversion to 16-bit.
+  PROFILER_STAGE_TOTAL,
+  PROFILER_STAGE_LAST
+};
+
+const int32_t kProfilerHistogramSize = 16;
+const int32_t kProfilerRingSize = 8;  // Must be a power of 2.
+
+struct ProfilerRecord {
+  uint8_t context;
+  uint16_t size;
+  uint16_t stages;  // Bitmask of the stages which ran for this block.
+  uint32_t ticks[PROFILER_STAGE_LAST];
+};
+
+struct ProfilerStats {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  // Bin i counts the blocks which took between i/16 and (i+1)/16 of their
+  // real-time budget; the last bin also counts the overruns.
+  uint32_t histogram[kProfilerHistogramSize];
+
+  inline uint32_t average() const {
+    return count ? static_cast<uint32_t>(sum / count) : 0;
+  }
+};
+
+class Profiler {
+ public:
+  Profiler() { }
+  ~Profiler() { }
+
+  void Init() {
+    CycleCounter::Init();
+    write_ptr_ = 0;
+    read_ptr_ = 0;
+    num_dropped_records_ = 0;
+    context_ = 0xff;
+    Reset();
+  }
+
+  void Reset() {
+    for (int32_t i = 0; i < PROFILER_STAGE_LAST; ++i) {
+      ProfilerStats* s = &stats_[i];
+      s->count = 0;
+      s->min = 0xffffffff;
+      s->max = 0;
+      s->sum = 0;
+      std::fill(&s->histogram[0], &s->histogram[kProfilerHistogramSize], 0);
+    }
+  }
+
+  // Called from the audio interrupt.
+  inline void Start(uint8_t context, size_t size) {
+    record_.context = context;
+    record_.size = size;
+    record_.stages = 0;
+    start_ = last_ = CycleCounter::Read();
+  }
+
+  inline void Mark(ProfilerStage stage) {
+    uint32_t now = CycleCounter::Read();
+    record_.ticks[stage] = now - last_;
+    record_.stages |= 1 << stage;
+    last_ = now;
+  }
+
+  inline void End() {
+    record_.ticks[PROFILER_STAGE_TOTAL] = CycleCounter::Read() - start_;
+    record_.stages |= 1 << PROFILER_STAGE_TOTAL;
+    size_t write_ptr = write_ptr_;
+    if (((write_ptr + 1) & (kProfilerRingSize - 1)) == read_ptr_) {
+      ++num_dropped_records_;
+      return;
+    }
+    ring_[write_ptr] = record_;
+    write_ptr_ = (write_ptr + 1) & (kProfilerRingSize - 1);
+  }
+
+  // Called from the main loop: folds the pending records in the statistics.
+  void Poll() {
+    while (read_ptr_ != write_ptr_) {
+      const ProfilerRecord& r = ring_[read_ptr_];
+      if (r.context != context_) {
+        context_ = r.context;
+        Reset();
+      }
+      uint32_t budget = static_cast<uint64_t>(CycleCounter::kTicksPerSecond) * \
+          r.size / 32000;
+      for (int32_t i = 0; i < PROFILER_STAGE_LAST; ++i) {
+        if (r.stages & (1 << i)) {
+          Accumulate(r.ticks[i], budget, &stats_[i]);
+        }
+      }
+      read_ptr_ = (read_ptr_ + 1) & (kProfilerRingSize - 1);
+    }
+  }
+
+  inline const ProfilerStats& stats(ProfilerStage stage) const {
+    return stats_[stage];
+  }
+
+  inline uint8_t context() const { return context_; }
+  inline uint32_t num_dropped_records() const { return num_dropped_records_; }
+
+  static const char* stage_name(ProfilerStage stage) {
+    static const char* const names[] = {
+      "input", "feedback", "src_down", "granular", "src_up", "diffuser",
+      "pitch_shifter", "filters", "dry_wet", "reverb", "output", "total"
+    };
+    return names[stage];
+  }
+
+ private:
+  static void Accumulate(uint32_t ticks, uint32_t budget, ProfilerStats* s) {
+    ++s->count;
+    s->sum += ticks;
+    if (ticks < s->min) {
+      s->min = ticks;
+    }
+    if (ticks > s->max) {
+      s->max = ticks;
+    }
+    uint32_t bin = budget
+        ? static_cast<uint64_t>(ticks) * kProfilerHistogramSize / budget
+        : 0;
+    if (bin >= static_cast<uint32_t>(kProfilerHistogramSize)) {
+      bin = kProfilerHistogramSize - 1;
+    }
+    ++s->histogram[bin];
+  }
+
+  ProfilerRecord record_;
+  uint32_t start_;
+  uint32_t last_;
+
+  ProfilerRecord ring_[kProfilerRingSize];
+  volatile size_t write_ptr_;
+  volatile size_t read_ptr_;
+  uint32_t num_dropped_records_;
+
+  uint8_t context_;
+  ProfilerStats stats_[PROFILER_STAGE_LAST];
+
+  DISALLOW_COPY_AND_ASSIGN(Profiler);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_DSP_PROFILER_H_
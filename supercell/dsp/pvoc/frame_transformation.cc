@@ -29,32 +29,88 @@
 #include "supercell/dsp/pvoc/frame_transformation.h"
 
 #include <algorithm>
+#include <cstring>
 
-#include "stmlib/dsp/atan.h"
 #include "stmlib/dsp/units.h"
-#include "stmlib/utils/random.h"
 
 #include "supercell/dsp/frame.h"
 #include "supercell/dsp/parameters.h"
+#include "supercell/dsp/pvoc/polar_conversion.h"
 
 namespace clouds {
 
 using namespace std;
 using namespace stmlib;
 
+namespace {
+
+union FloatBits {
+  float f;
+  uint32_t u;
+};
+
+struct FloatTexture {
+  typedef float Sample;
+  static inline float Decode(Sample s) { return s; }
+  static inline Sample Encode(float x) { return x; }
+};
+
+// Magnitudes are positive: the sign bit is dropped, 8 bits of exponent and 8
+// bits of mantissa are kept, rounded.
+struct Log16Texture {
+  typedef uint16_t Sample;
+  static inline float Decode(Sample s) {
+    FloatBits bits;
+    bits.u = static_cast<uint32_t>(s) << 15;
+    return bits.f;
+  }
+  static inline Sample Encode(float x) {
+    FloatBits bits;
+    bits.f = x;
+    return (bits.u + (1 << 14)) >> 15;
+  }
+};
+
+// 5 bits of exponent and 3 of mantissa, covering magnitudes from 2^-3 to 2^29
+// (a full scale sine is about 2^26 with the largest FFT). 0 stands for
+// anything below.
+struct Log8Texture {
+  typedef uint8_t Sample;
+  static const int32_t kOffset = (127 - 3) << 3;
+  static inline float Decode(Sample s) {
+    FloatBits bits;
+    bits.u = s ? static_cast<uint32_t>(s + kOffset) << 20 : 0;
+    return bits.f;
+  }
+  static inline Sample Encode(float x) {
+    FloatBits bits;
+    bits.f = x;
+    int32_t s = static_cast<int32_t>((bits.u + (1 << 19)) >> 20) - kOffset;
+    CONSTRAIN(s, 0, 255);
+    return s;
+  }
+};
+
+}  // namespace
+
 void FrameTransformation::Init(
     float* buffer,
     int32_t fft_size,
     int32_t num_textures,
-    float, FFT*) {
+    float, FFT*,
+    RandomGenerator* random) {
+  random_ = random;
   fft_size_ = fft_size;
   size_ = (fft_size >> 1) - kHighFrequencyTruncation;
   
-  for (int32_t i = 0; i < num_textures; ++i) {
-    textures_[i] = &buffer[i * size_];
+  // Last slot(s) are used for storing phases.
+  num_textures_ = num_textures - num_phase_slots();
+  size_t slot_size = texture_size(fft_size);
+  for (int32_t i = 0; i < num_textures_; ++i) {
+    textures_[i] = &buffer[i * slot_size];
   }
-  phases_ = static_cast<uint16_t*>((void*)(textures_[num_textures - 1]));
-  num_textures_ = num_textures - 1;  // Last texture is used for storing phases.
+  phases_ = static_cast<uint16_t*>((void*)(&buffer[
+      num_textures_ * slot_size]));
   phases_delta_ = phases_ + size_;
 
   glitch_algorithm_ = 0;
@@ -62,8 +118,62 @@ void FrameTransformation::Init(
 }
 
 void FrameTransformation::Reset() {
-  for (int32_t i = 0; i < num_textures_; ++i) {
-    fill(&textures_[i][0], &textures_[i][size_], 0.0f);
+  // All the formats encode 0 with zero bits.
+  uint8_t* textures = static_cast<uint8_t*>(textures_[0]);
+  fill(&textures[0], &textures[num_textures_ * size_ * bytes_per_sample()], 0);
+}
+
+/* static */
+void FrameTransformation::MapParameters(Parameters* parameters) {
+  parameters->spectral.quantization = parameters->texture;
+  parameters->spectral.refresh_rate = 0.01f + 0.99f * parameters->density;
+  float warp = parameters->size - 0.5f;
+  parameters->spectral.warp = 4.0f * warp * warp * warp + 0.5f;
+
+  float randomization = parameters->density - 0.5f;
+  randomization *= randomization * 4.2f;
+  randomization -= 0.05f;
+  CONSTRAIN(randomization, 0.0f, 1.0f);
+  parameters->spectral.phase_randomization = randomization;
+}
+
+void FrameTransformation::PackSnapshot() {
+  if (texture_format_ != TEXTURE_FORMAT_FLOAT) {
+    return;  // Textures and phases are already contiguous.
+  }
+  // The textures are converted in place, from the start, and the phases are
+  // moved right after them. Copies through bytes keep the compiler from
+  // assuming that the float and 16-bit views do not overlap.
+  uint8_t* bytes = static_cast<uint8_t*>(textures_[0]);
+  size_t size = num_textures_ * size_;
+  for (size_t i = 0; i < size; ++i) {
+    float x;
+    memcpy(&x, &bytes[i * sizeof(float)], sizeof(float));
+    uint16_t s = Log16Texture::Encode(x);
+    memcpy(&bytes[i * sizeof(uint16_t)], &s, sizeof(uint16_t));
+  }
+  memmove(
+      &bytes[size * sizeof(uint16_t)],
+      phases_,
+      2 * size_ * sizeof(uint16_t));
+}
+
+void FrameTransformation::UnpackSnapshot() {
+  if (texture_format_ != TEXTURE_FORMAT_FLOAT) {
+    return;
+  }
+  // Same as above, backwards.
+  uint8_t* bytes = static_cast<uint8_t*>(textures_[0]);
+  size_t size = num_textures_ * size_;
+  memmove(
+      phases_,
+      &bytes[size * sizeof(uint16_t)],
+      2 * size_ * sizeof(uint16_t));
+  for (size_t i = size; i--; ) {
+    uint16_t s;
+    memcpy(&s, &bytes[i * sizeof(uint16_t)], sizeof(uint16_t));
+    float x = Log16Texture::Decode(s);
+    memcpy(&bytes[i * sizeof(float)], &x, sizeof(float));
   }
 }
 
@@ -86,7 +196,10 @@ void FrameTransformation::Process(
         parameters.position,
         parameters.spectral.refresh_rate);
   }
-  float* temp = &fft_out[0];
+  // The imaginary half of fft_out is free once the phases are extracted, and
+  // is not written before SetPhases() when fft_out and ifft_in are the same
+  // buffer.
+  float* temp = &fft_out[fft_size_ >> 1];
   ReplayMagnitudes(ifft_in, parameters.position);
   WarpMagnitudes(ifft_in, temp, parameters.spectral.warp);
   ShiftMagnitudes(temp, ifft_in, pitch_ratio);
@@ -100,7 +213,7 @@ void FrameTransformation::Process(
   if (!glitch) {
     // Decide on which glitch algorithm will be used next time... if glitch
     // is enabled on the next frame!
-    glitch_algorithm_ = stmlib::Random::GetSample() & 3;
+    glitch_algorithm_ = random_->GetSample() & 3;
   }
 
   ifft_in[0] = 0.0f;
@@ -111,8 +224,11 @@ void FrameTransformation::RectangularToPolar(float* fft_data) {
   float* real = &fft_data[0];
   float* imag = &fft_data[fft_size_ >> 1];
   float* magnitude = &fft_data[0];
+  // The new phases are written to phases_delta_ first.
+  ConvertToPolar(&real[1], &imag[1], &magnitude[1], &phases_delta_[1],
+                 size_ - 1);
   for (int32_t i = 1; i < size_; ++i) {
-    uint16_t angle = fast_atan2r(imag[i], real[i], &magnitude[i]);
+    uint16_t angle = phases_delta_[i];
     phases_delta_[i] = angle - phases_[i];
     phases_[i] = angle;
   }
@@ -133,9 +249,14 @@ void FrameTransformation::SetPhases(
   CONSTRAIN(r, 0.0f, 1.0f);
   r *= r;
   int32_t amount = static_cast<int32_t>(r * 32768.0f);
-  for (int32_t i = 0; i < size_; ++i) {
-    synthesis_phase[i] += \
-        static_cast<int32_t>(stmlib::Random::GetSample()) * amount >> 14;
+  int16_t random[kRandomBlockSize];
+  for (int32_t i = 0; i < size_; i += kRandomBlockSize) {
+    int32_t block_size = min(size_ - i, int32_t(kRandomBlockSize));
+    random_->FillSamples(random, block_size);
+    for (int32_t j = 0; j < block_size; ++j) {
+      synthesis_phase[i + j] += \
+          static_cast<int32_t>(random[j]) * amount >> 14;
+    }
   }
 }
 
@@ -144,9 +265,8 @@ void FrameTransformation::PolarToRectangular(float* fft_data) {
   float* imag = &fft_data[fft_size_ >> 1];
   float* magnitude = &fft_data[0];
   uint32_t* angle = (uint32_t*) &fft_data[fft_size_ >> 1];
-  for (int32_t i = 1; i < size_; ++i) {
-    fast_p2r(magnitude[i], angle[i], &real[i], &imag[i]);
-  }
+  ConvertToRectangular(&magnitude[1], &angle[1], &real[1], &imag[1],
+                       size_ - 1);
   for (int32_t i = size_; i < fft_size_ >> 1; ++i) {
     real[i] = imag[i] = 0.0f;
   }
@@ -161,7 +281,7 @@ void FrameTransformation::AddGlitch(float* xf_polar) {
         // Create trails
         float held = 0.0;
         for (int32_t i = 0; i < size_; ++i) {
-          if ((stmlib::Random::GetSample() & 15) == 0) {
+          if ((random_->GetSample() & 15) == 0) {
             held = x[i];
           }
           x[i] = held;
@@ -173,7 +293,7 @@ void FrameTransformation::AddGlitch(float* xf_polar) {
     case 1:
       // Spectral shift up with aliasing.
       {
-        float factor = 1.0f + (stmlib::Random::GetSample() & 7) / 4.0f;
+        float factor = 1.0f + (random_->GetSample() & 7) / 4.0f;
         float source = 0.0f;
         for (int32_t i = 0; i < size_; ++i) {
           source += factor;
@@ -195,7 +315,7 @@ void FrameTransformation::AddGlitch(float* xf_polar) {
       {
         // Nasty high-pass
         for (int32_t i = 0; i < size_; ++i) {
-          uint32_t random = stmlib::Random::GetSample() & 15;
+          uint32_t random = random_->GetSample() & 15;
           if (random == 0) {
             x[i] *= static_cast<float>(i) / 16.0f;
           }
@@ -273,30 +393,47 @@ void FrameTransformation::ShiftMagnitudes(
     float* xf_polar,
     float pitch_ratio) {
   float* destination = &xf_polar[0];
-  float* temp = &xf_polar[size_];
   if (pitch_ratio == 1.0f) {
-    copy(&source[0], &source[size_], &temp[0]);
+    copy(&source[0], &source[size_], &destination[0]);
   } else if (pitch_ratio > 1.0f) {
     float index = 1.0f;
     float increment = 1.0f / pitch_ratio;
+    destination[0] = source[0];
     for (int32_t i = 1; i < size_; ++i) {
-      temp[i] = Interpolate(source, index, 1.0f);
+      destination[i] = Interpolate(source, index, 1.0f);
       index += increment;
     }
   } else {
-    fill(&temp[0], &temp[size_], 0.0f);
+    fill(&destination[0], &destination[size_], 0.0f);
     float index = 1.0f;
     float increment = pitch_ratio;
     for (int32_t i = 1; i < size_; ++i) {
       MAKE_INTEGRAL_FRACTIONAL(index)
-      temp[index_integral] += (1.0f - index_fractional) * source[i];
-      temp[index_integral + 1] += index_fractional * source[i];
+      destination[index_integral] += (1.0f - index_fractional) * source[i];
+      destination[index_integral + 1] += index_fractional * source[i];
       index += increment;
     }
   }
-  copy(&temp[0], &temp[size_], &destination[0]);
 }
 
+void FrameTransformation::StoreMagnitudes(
+    float* xf_polar,
+    float position,
+    float feedback) {
+  switch (texture_format_) {
+    case TEXTURE_FORMAT_16_BIT_LOG:
+      StoreMagnitudes<Log16Texture>(xf_polar, position, feedback);
+      break;
+    case TEXTURE_FORMAT_8_BIT_LOG:
+      StoreMagnitudes<Log8Texture>(xf_polar, position, feedback);
+      break;
+    default:
+      StoreMagnitudes<FloatTexture>(xf_polar, position, feedback);
+      break;
+  }
+}
+
+template<typename Texture>
 void FrameTransformation::StoreMagnitudes(
     float* xf_polar,
     float position,
@@ -308,8 +445,10 @@ void FrameTransformation::StoreMagnitudes(
   float gain_a = 1.0f - index_fractional;
   float gain_b = index_fractional;
   
-  float* a = textures_[index_int];
-  float* b = textures_[index_int + (position == 1.0f ? 0 : 1)];
+  typename Texture::Sample* a = static_cast<typename Texture::Sample*>(
+      textures_[index_int]);
+  typename Texture::Sample* b = static_cast<typename Texture::Sample*>(
+      textures_[index_int + (position == 1.0f ? 0 : 1)]);
   
   if (feedback >= 0.5f) {
     feedback = 2.0f * (feedback - 0.5f);
@@ -318,8 +457,8 @@ void FrameTransformation::StoreMagnitudes(
       gain_b *= 1.0f - feedback;
       for (int32_t i = 0; i < size_; ++i) {
         float x = *xf_polar++;
-        a[i] = Crossfade(a[i], x, gain_a);
-        b[i] = Crossfade(b[i], x, gain_b);
+        a[i] = Texture::Encode(Crossfade(Texture::Decode(a[i]), x, gain_a));
+        b[i] = Texture::Encode(Crossfade(Texture::Decode(b[i]), x, gain_b));
       }
     } else {
       float t = (feedback - 0.5f) * 0.7f + 0.5f;
@@ -331,32 +470,62 @@ void FrameTransformation::StoreMagnitudes(
       float gain_old_b = 1.0f - gain_b * (1.0f - t);
       for (int32_t i = 0; i < size_; ++i) {
         float x = *xf_polar++;
-        a[i] = a[i] * gain_old_a + x * gain_new_a;
-        b[i] = b[i] * gain_old_b + x * gain_new_b;
+        a[i] = Texture::Encode(
+            Texture::Decode(a[i]) * gain_old_a + x * gain_new_a);
+        b[i] = Texture::Encode(
+            Texture::Decode(b[i]) * gain_old_b + x * gain_new_b);
       }
     }
   } else {
     feedback *= 2.0f;
     feedback *= feedback;
     uint16_t threshold = feedback * 65535.0f;
-    for (int32_t i = 0; i < size_; ++i) {
-      float x = *xf_polar++;
-      float gain = static_cast<uint16_t>(Random::GetSample()) <= threshold
-          ? 1.0f : 0.0f;
-      a[i] = Crossfade(a[i], x, gain_a * gain);
-      b[i] = Crossfade(b[i], x, gain_b * gain);
+    int16_t random[kRandomBlockSize];
+    for (int32_t i = 0; i < size_; i += kRandomBlockSize) {
+      int32_t block_size = min(size_ - i, int32_t(kRandomBlockSize));
+      random_->FillSamples(random, block_size);
+      for (int32_t j = 0; j < block_size; ++j) {
+        float x = *xf_polar++;
+        float gain = static_cast<uint16_t>(random[j]) <= threshold
+            ? 1.0f : 0.0f;
+        a[i + j] = Texture::Encode(
+            Crossfade(Texture::Decode(a[i + j]), x, gain_a * gain));
+        b[i + j] = Texture::Encode(
+            Crossfade(Texture::Decode(b[i + j]), x, gain_b * gain));
+      }
     }
   }
 }
 
+void FrameTransformation::ReplayMagnitudes(float* xf_polar, float position) {
+  switch (texture_format_) {
+    case TEXTURE_FORMAT_16_BIT_LOG:
+      ReplayMagnitudes<Log16Texture>(xf_polar, position);
+      break;
+    case TEXTURE_FORMAT_8_BIT_LOG:
+      ReplayMagnitudes<Log8Texture>(xf_polar, position);
+      break;
+    default:
+      ReplayMagnitudes<FloatTexture>(xf_polar, position);
+      break;
+  }
+}
+
+template<typename Texture>
 void FrameTransformation::ReplayMagnitudes(float* xf_polar, float position) {
   float index_float = position * float(num_textures_ - 1);
   int32_t index_int = static_cast<int32_t>(index_float);
   float index_fractional = index_float - static_cast<float>(index_int);
-  float* a = textures_[index_int];
-  float* b = textures_[index_int + (position == 1.0f ? 0 : 1)];
+  const typename Texture::Sample* a = \
+      static_cast<const typename Texture::Sample*>(textures_[index_int]);
+  const typename Texture::Sample* b = \
+      static_cast<const typename Texture::Sample*>(
+          textures_[index_int + (position == 1.0f ? 0 : 1)]);
   for (int32_t i = 0; i < size_; ++i) {
-    xf_polar[i] = Crossfade(a[i], b[i], index_fractional);
+    xf_polar[i] = Crossfade(
+        Texture::Decode(a[i]),
+        Texture::Decode(b[i]),
+        index_fractional);
   }
 }
 
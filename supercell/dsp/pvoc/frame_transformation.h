@@ -31,33 +31,77 @@
 
 #include "stmlib/stmlib.h"
 
+#include <algorithm>
+
 #include "supercell/dsp/pvoc/stft.h"
 #include "supercell/dsp/pvoc/modifier.h"
+#include "supercell/dsp/random_generator.h"
 #include "supercell/resources.h"
 
 namespace clouds {
 
 struct Parameters;
 
+// Storage of the magnitude textures. The compressed formats keep the exponent
+// and the upper bits of the mantissa of the float magnitudes, a piecewise
+// linear approximation of their logarithm, and fit 2 or 4 times more textures
+// in the same memory.
+enum TextureFormat {
+  TEXTURE_FORMAT_FLOAT,
+  TEXTURE_FORMAT_16_BIT_LOG,  // 1/256th of an octave steps.
+  TEXTURE_FORMAT_8_BIT_LOG,  // 1/8th of an octave steps, 32 octaves range.
+  TEXTURE_FORMAT_LAST
+};
+
 class FrameTransformation : public Modifier {
  public:
-  FrameTransformation() { }
+  FrameTransformation() : texture_format_(TEXTURE_FORMAT_FLOAT) { }
   ~FrameTransformation() { }
 
-  static const int32_t kMaxNumTextures = 7;
+  static const int32_t kMaxNumTextures = 32;
   static const int32_t kHighFrequencyTruncation = 16;
 
-  virtual uint32_t num_textures() const {
-    return kMaxNumTextures;
+  // Takes effect with the next call to Init().
+  inline void set_texture_format(TextureFormat texture_format) {
+    texture_format_ = texture_format;
+  }
+
+  // Textures are counted in slots of texture_size() floats, one magnitude
+  // texture each. The phases take the last slot(s): one with float textures,
+  // 2 or 4 with the compressed ones. Float textures are limited to 7 slots
+  // with the largest FFT, more with the smaller ones, which take less memory;
+  // compressed textures only by the memory left.
+  virtual uint32_t num_textures(size_t fft_size) const {
+    if (texture_format_ == TEXTURE_FORMAT_FLOAT) {
+      return std::min(static_cast<size_t>(16), 7 * kMaxFftSize / fft_size);
+    } else {
+      return kMaxNumTextures + num_phase_slots();
+    }
   }
 
   virtual uint32_t texture_size(size_t fft_size) const {
-    return (fft_size >> 1) - kHighFrequencyTruncation;
+    return (((fft_size >> 1) - kHighFrequencyTruncation) * \
+        bytes_per_sample()) / sizeof(float);
   }
 
   virtual void Init(float* buffer, int32_t fft_size, int32_t num_textures,
-            float sample_rate_hz, FFT* fft);
+            float sample_rate_hz, FFT* fft, RandomGenerator* random);
   void Reset();
+
+  // Derives the settings of the transformation (parameters->spectral) from
+  // the knobs.
+  static void MapParameters(Parameters* parameters);
+
+  // The textures, followed by the phases. Float textures are saved as 16-bit
+  // log magnitudes.
+  virtual void* snapshot(size_t* size) {
+    *size = num_textures_ * size_ * (
+        texture_format_ == TEXTURE_FORMAT_FLOAT ? sizeof(uint16_t) :
+        bytes_per_sample()) + 2 * size_ * sizeof(uint16_t);
+    return textures_[0];
+  }
+  virtual void PackSnapshot();
+  virtual void UnpackSnapshot();
   
   virtual void Process(
       const Parameters& parameters,
@@ -66,6 +110,16 @@ class FrameTransformation : public Modifier {
       bool trigger);
   
  private:
+  inline size_t bytes_per_sample() const {
+    return texture_format_ == TEXTURE_FORMAT_FLOAT ? sizeof(float) :
+        (texture_format_ == TEXTURE_FORMAT_16_BIT_LOG ? sizeof(uint16_t) :
+        sizeof(uint8_t));
+  }
+
+  inline uint32_t num_phase_slots() const {
+    return sizeof(float) / bytes_per_sample();
+  }
+
   void RectangularToPolar(float* fft_data);
   void PolarToRectangular(float* fft_data);
   void AddGlitch(float* xf_polar);
@@ -79,28 +133,29 @@ class FrameTransformation : public Modifier {
       float amount);
   void QuantizeMagnitudes(float* xf_polar, float amount);
   void StoreMagnitudes(float* xf_polar, float position, float feedback);
+  template<typename Texture>
+  void StoreMagnitudes(float* xf_polar, float position, float feedback);
   void SetPhases(float* destination, float diffusion, float pitch_ratio);
   void ReplayMagnitudes(float* xf_polar, float position);
+  template<typename Texture>
+  void ReplayMagnitudes(float* xf_polar, float position);
   void DiffuseMagnitudes(float* xf_polar, float diffusion);
   
-  inline void fast_p2r(float magnitude, uint16_t angle, float* re, float* im) {
-    angle >>= 6;
-    *re = magnitude * lut_sin[angle + 256];
-    *im = magnitude * lut_sin[angle];
-  }
-  
   int32_t fft_size_;
   int32_t num_textures_;
   int32_t size_;
+  TextureFormat texture_format_;
   
-  // Magnitude buffers.
-  float* textures_[kMaxNumTextures];
+  // Magnitude buffers, in texture_format_.
+  void* textures_[kMaxNumTextures];
   
   // Original phase and phase unrolling buffers.
   uint16_t* phases_;
   uint16_t* phases_delta_;
 
   int8_t glitch_algorithm_;
+
+  RandomGenerator* random_;
   
   DISALLOW_COPY_AND_ASSIGN(FrameTransformation);
 };
@@ -34,18 +34,29 @@
 namespace clouds {
 
 struct Parameters;
+class RandomGenerator;
 
 class Modifier {
 public:
   Modifier() { }
   virtual ~Modifier() { }
 
-  virtual uint32_t num_textures() const = 0;
+  virtual uint32_t num_textures(size_t fft_size) const = 0;
   virtual uint32_t texture_size(size_t texture_size) const = 0;
 
   virtual void Init(float* buffer, int32_t fft_size, int32_t num_textures,
-                    float sample_rate_hz, FFT* fft) = 0;
+                    float sample_rate_hz, FFT* fft,
+                    RandomGenerator* random) = 0;
 
+  // State needed to resume a frozen sound, saved with the sample memories.
+  // PackSnapshot() gets it ready to be copied from snapshot() - it may be
+  // compressed in place, and left unusable until UnpackSnapshot() is called,
+  // once it has been copied back.
+  virtual void* snapshot(size_t* size) = 0;
+  virtual void PackSnapshot() { }
+  virtual void UnpackSnapshot() { }
+
+  // fft_out and ifft_in may be the same buffer (see STFT::set_partner()).
   virtual void Process(const Parameters& parameters, float* fft_out, float* ifft_in, bool trigger) = 0;
 };
 
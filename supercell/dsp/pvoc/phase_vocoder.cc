@@ -32,6 +32,8 @@
 
 #include "stmlib/utils/buffer_allocator.h"
 
+#include "supercell/drivers/cycle_counter.h"
+
 namespace clouds {
 
 using namespace std;
@@ -57,6 +59,14 @@ void PhaseVocoder::Init() {
 
   new(&spectral_clouds_transformation_[0]) SpectralCloudsTransformation();
   new(&spectral_clouds_transformation_[1]) SpectralCloudsTransformation();
+  modifier_[0] = &frame_transformation_[0];
+  modifier_[1] = &frame_transformation_[1];
+
+  channel_ = 0;
+  time_budget_ = 0;
+  texture_format_ = TEXTURE_FORMAT_FLOAT;
+  paired_transforms_ = false;
+  paired_ = false;
 }
 
 void PhaseVocoder::Init(
@@ -64,34 +74,43 @@ void PhaseVocoder::Init(
     void** buffer,
     size_t* buffer_size,
     const float* large_window_lut,
-    size_t largest_fft_size,
+    size_t fft_size,
+    size_t hop_ratio,
     int32_t num_channels,
     int32_t resolution,
-    float sample_rate) {
+    float sample_rate,
+    RandomGenerator* random) {
   num_channels_ = num_channels;
+  channel_ = 0;
 
-  size_t fft_size = largest_fft_size;
-  size_t hop_ratio = 4;
-  
   BufferAllocator allocator_0(buffer[0], buffer_size[0]);
   BufferAllocator allocator_1(buffer[1], buffer_size[1]);
   BufferAllocator* allocator[2] = { &allocator_0, &allocator_1 };
-  float* fft_buffer = allocator[0]->Allocate<float>(fft_size);
-  float* ifft_buffer = allocator[num_channels_ - 1]->Allocate<float>(fft_size);
+  // The FFT and the IFFT write to different buffers, shared by the channels.
+  // When the transforms are paired, both channels of a stereo signal go
+  // through a single complex transform, in place, and each channel gets one
+  // of the buffers.
+  paired_ = paired_transforms_ && num_channels_ == 2;
+  float* fft_buffer[2];
+  fft_buffer[0] = allocator[0]->Allocate<float>(fft_size);
+  fft_buffer[1] = allocator[num_channels_ - 1]->Allocate<float>(fft_size);
 
-  Modifier *modifiers[2];
   if (TRANSFORMATION_TYPE_FRAME == transformation_type) {
-    modifiers[0] = &frame_transformation_[0];
-    modifiers[1] = &frame_transformation_[1];
+    modifier_[0] = &frame_transformation_[0];
+    modifier_[1] = &frame_transformation_[1];
+    frame_transformation_[0].set_texture_format(texture_format_);
+    frame_transformation_[1].set_texture_format(texture_format_);
   } else {
-    modifiers[0] = &spectral_clouds_transformation_[0];
-    modifiers[1] = &spectral_clouds_transformation_[1];
+    modifier_[0] = &spectral_clouds_transformation_[0];
+    modifier_[1] = &spectral_clouds_transformation_[1];
   }
 
-  size_t num_textures = modifiers[0]->num_textures();
-  size_t texture_size = modifiers[0]->texture_size(fft_size);
+  size_t num_textures = modifier_[0]->num_textures(fft_size);
+  size_t texture_size = modifier_[0]->texture_size(fft_size);
 
   for (int32_t i = 0; i < num_channels_; ++i) {
+    // Analysis and synthesis buffers, of fft_size + hop_size samples each -
+    // room is left for the largest hop, fft_size / 2.
     short* ana_syn_buffer = allocator[i]->Allocate<short>(
         (fft_size + (fft_size >> 1)) * 2);
     
@@ -102,16 +121,20 @@ void PhaseVocoder::Init(
         &fft_,
         fft_size,
         fft_size / hop_ratio,
-        fft_buffer,
-        ifft_buffer,
+        fft_buffer[paired_ ? i : 0],
+        fft_buffer[paired_ ? i : 1],
         large_window_lut,
         ana_syn_buffer,
-        modifiers[i]);
+        modifier_[i]);
+  }
+  if (paired_) {
+    stft_[0].set_partner(&stft_[1]);
   }
   for (int32_t i = 0; i < num_channels_; ++i) {
     float* texture_buffer = allocator[i]->Allocate<float>(
         num_textures * texture_size);
-    modifiers[i]->Init(texture_buffer, fft_size, num_textures, sample_rate, &fft_);
+    modifier_[i]->Init(
+        texture_buffer, fft_size, num_textures, sample_rate, &fft_, random);
   }
 }
 
@@ -133,8 +156,35 @@ void PhaseVocoder::Process(
 }
 
 void PhaseVocoder::Buffer() {
+  uint32_t start = CycleCounter::Read();
+  if (paired_) {
+    // The first STFT also processes the hops of the second one.
+    stft_[0].Buffer(start, time_budget_);
+    return;
+  }
+
+  // The channels share the FFT buffers, so a channel must be done with its
+  // hop before the other one starts.
+  for (int32_t i = 0; i < num_channels_; ++i) {
+    if (!stft_[channel_].Buffer(start, time_budget_)) {
+      return;
+    }
+    channel_ = channel_ + 1 == num_channels_ ? 0 : channel_ + 1;
+    if (time_budget_ && CycleCounter::Read() - start >= time_budget_) {
+      return;
+    }
+  }
+}
+
+void PhaseVocoder::PackSnapshots() {
+  for (int32_t i = 0; i < num_channels_; ++i) {
+    modifier_[i]->PackSnapshot();
+  }
+}
+
+void PhaseVocoder::UnpackSnapshots() {
   for (int32_t i = 0; i < num_channels_; ++i) {
-    stft_[i].Buffer();
+    modifier_[i]->UnpackSnapshot();
   }
 }
 
@@ -57,10 +57,21 @@ class PhaseVocoder {
   void Init(
       TransformationType transformation_type,
       void** buffer, size_t* buffer_size,
-      const float* large_window_lut, size_t largest_fft_size,
+      const float* large_window_lut,
+      size_t fft_size,
+      size_t hop_ratio,
       int32_t num_channels,
       int32_t resolution,
-      float sample_rate);
+      float sample_rate,
+      RandomGenerator* random);
+
+  // Smallest buffer of each channel for Init() to fit the STFT buffers and
+  // two float textures.
+  static inline size_t min_buffer_size(size_t fft_size, int32_t num_channels) {
+    return fft_size * sizeof(float) * (num_channels == 1 ? 2 : 1) + \
+        (fft_size + (fft_size >> 1)) * 2 * sizeof(short) + \
+        2 * (fft_size >> 1) * sizeof(float);
+  }
 
   void Process(
       const Parameters& parameters,
@@ -68,6 +79,33 @@ class PhaseVocoder {
       FloatFrame* output,
       size_t size);
   void Buffer();
+
+  // State of the transformation of each channel, saved with the sample
+  // memories (see Modifier::snapshot()).
+  inline void* snapshot(int32_t channel, size_t* size) {
+    return modifier_[channel]->snapshot(size);
+  }
+  void PackSnapshots();
+  void UnpackSnapshots();
+
+  // Time after which Buffer() returns, and resumes on the next call, in
+  // CycleCounter ticks. With 0, each call processes a full hop.
+  inline void set_time_budget(uint32_t time_budget) {
+    time_budget_ = time_budget;
+  }
+
+  // Storage of the textures of the frame transformation, applied by the next
+  // call to Init().
+  inline void set_texture_format(TextureFormat texture_format) {
+    texture_format_ = texture_format;
+  }
+
+  // When enabled, the two channels of a stereo signal share a single complex
+  // FFT and IFFT per hop (see STFT::set_partner()), rather than one real
+  // transform each. Applied by the next call to Init().
+  inline void set_paired_transforms(bool paired_transforms) {
+    paired_transforms_ = paired_transforms;
+  }
   
  private:
   FFT fft_;
@@ -75,8 +113,14 @@ class PhaseVocoder {
   STFT stft_[2];
   FrameTransformation frame_transformation_[2];
   SpectralCloudsTransformation spectral_clouds_transformation_[2];
+  Modifier* modifier_[2];
 
   int32_t num_channels_;
+  int32_t channel_;
+  uint32_t time_budget_;
+  TextureFormat texture_format_;
+  bool paired_transforms_;
+  bool paired_;
 
   DISALLOW_COPY_AND_ASSIGN(PhaseVocoder);
 };
@@ -0,0 +1,177 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Conversions of whole spectra between rectangular and polar form, shared by
+// the modifiers of the phase vocoder. Angles are in 1/65536 of a turn.
+
+#ifndef CLOUDS_DSP_PVOC_POLAR_CONVERSION_H_
+#define CLOUDS_DSP_PVOC_POLAR_CONVERSION_H_
+
+#include "stmlib/stmlib.h"
+
+#include <cmath>
+
+#if defined(TEST) && defined(__SSE2__)
+  #include <emmintrin.h>
+  #define CLOUDS_POLAR_CONVERSION_SSE2
+#endif
+
+#include "supercell/resources.h"
+
+namespace clouds {
+
+// Minimax polynomial for atan(t), t in [0, 1], scaled to 1/65536 of a turn:
+// the error is below 0.12 of a step.
+const float kAtanScale = 65536.0f / 6.28318530718f;
+const float kAtanC1 = 0.9998660f * kAtanScale;
+const float kAtanC3 = -0.3302995f * kAtanScale;
+const float kAtanC5 = 0.1801410f * kAtanScale;
+const float kAtanC7 = -0.0851330f * kAtanScale;
+const float kAtanC9 = 0.0208351f * kAtanScale;
+
+// Avoids the division of 0 by 0 for an empty bin, whose angle is then 0.
+const float kAtanEpsilon = 1e-30f;
+
+// Converts size bins to magnitudes and angles. magnitude can be re.
+inline void ConvertToPolar(
+    const float* re,
+    const float* im,
+    float* magnitude,
+    uint16_t* angle,
+    size_t size) {
+  size_t i = 0;
+#ifdef CLOUDS_POLAR_CONVERSION_SSE2
+  // Four bins at a time, the octant being folded with masks.
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  const __m128 epsilon = _mm_set1_ps(kAtanEpsilon);
+  const __m128 quarter = _mm_set1_ps(16384.0f);
+  const __m128 half = _mm_set1_ps(32768.0f);
+  const __m128 zero = _mm_setzero_ps();
+  for (; i + 4 <= size; i += 4) {
+    __m128 x = _mm_loadu_ps(&re[i]);
+    __m128 y = _mm_loadu_ps(&im[i]);
+    __m128 ax = _mm_and_ps(x, abs_mask);
+    __m128 ay = _mm_and_ps(y, abs_mask);
+    __m128 t = _mm_div_ps(
+        _mm_min_ps(ax, ay),
+        _mm_add_ps(_mm_max_ps(ax, ay), epsilon));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 a = _mm_add_ps(
+        _mm_mul_ps(_mm_set1_ps(kAtanC9), t2), _mm_set1_ps(kAtanC7));
+    a = _mm_add_ps(_mm_mul_ps(a, t2), _mm_set1_ps(kAtanC5));
+    a = _mm_add_ps(_mm_mul_ps(a, t2), _mm_set1_ps(kAtanC3));
+    a = _mm_add_ps(_mm_mul_ps(a, t2), _mm_set1_ps(kAtanC1));
+    a = _mm_mul_ps(a, t);
+
+    __m128 mask = _mm_cmpgt_ps(ay, ax);
+    a = _mm_or_ps(
+        _mm_and_ps(mask, _mm_sub_ps(quarter, a)), _mm_andnot_ps(mask, a));
+    mask = _mm_cmplt_ps(x, zero);
+    a = _mm_or_ps(
+        _mm_and_ps(mask, _mm_sub_ps(half, a)), _mm_andnot_ps(mask, a));
+    mask = _mm_cmplt_ps(y, zero);
+    a = _mm_or_ps(
+        _mm_and_ps(mask, _mm_sub_ps(zero, a)), _mm_andnot_ps(mask, a));
+
+    __m128i a32 = _mm_cvttps_epi32(a);
+    int32_t angles[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(angles), a32);
+    _mm_storeu_ps(
+        &magnitude[i],
+        _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y))));
+    for (size_t j = 0; j < 4; ++j) {
+      angle[i + j] = static_cast<uint16_t>(angles[j]);
+    }
+  }
+#endif  // CLOUDS_POLAR_CONVERSION_SSE2
+  for (; i < size; ++i) {
+    float x = re[i];
+    float y = im[i];
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    bool steep = ay > ax;
+    float t = (steep ? ax : ay) / ((steep ? ay : ax) + kAtanEpsilon);
+    float t2 = t * t;
+    float a = kAtanC9 * t2 + kAtanC7;
+    a = a * t2 + kAtanC5;
+    a = a * t2 + kAtanC3;
+    a = a * t2 + kAtanC1;
+    a *= t;
+    if (steep) {
+      a = 16384.0f - a;
+    }
+    if (x < 0.0f) {
+      a = 32768.0f - a;
+    }
+    if (y < 0.0f) {
+      a = -a;
+    }
+    magnitude[i] = sqrtf(x * x + y * y);
+    angle[i] = static_cast<uint16_t>(static_cast<int32_t>(a));
+  }
+}
+
+// Converts size bins from magnitudes and angles, looking up the 10 MSBs of
+// the angle (only the 16 LSBs of T are used) in lut_sin. re can be
+// magnitude, and im can be angle when T is 32-bit.
+template<typename T>
+inline void ConvertToRectangular(
+    const float* magnitude,
+    const T* angle,
+    float* re,
+    float* im,
+    size_t size) {
+  size_t i = 0;
+#ifdef CLOUDS_POLAR_CONVERSION_SSE2
+  // Four bins at a time: the indices are computed together, and the sines
+  // and cosines gathered from the table.
+  for (; i + 4 <= size; i += 4) {
+    size_t index[4];
+    for (size_t j = 0; j < 4; ++j) {
+      index[j] = static_cast<uint16_t>(angle[i + j]) >> 6;
+    }
+    __m128 m = _mm_loadu_ps(&magnitude[i]);
+    __m128 c = _mm_setr_ps(
+        lut_sin[index[0] + 256], lut_sin[index[1] + 256],
+        lut_sin[index[2] + 256], lut_sin[index[3] + 256]);
+    __m128 s = _mm_setr_ps(
+        lut_sin[index[0]], lut_sin[index[1]],
+        lut_sin[index[2]], lut_sin[index[3]]);
+    _mm_storeu_ps(&re[i], _mm_mul_ps(m, c));
+    _mm_storeu_ps(&im[i], _mm_mul_ps(m, s));
+  }
+#endif  // CLOUDS_POLAR_CONVERSION_SSE2
+  for (; i < size; ++i) {
+    size_t index = static_cast<uint16_t>(angle[i]) >> 6;
+    float m = magnitude[i];
+    re[i] = m * lut_sin[index + 256];
+    im[i] = m * lut_sin[index];
+  }
+}
+
+}  // namespace clouds
+
+#endif  // CLOUDS_DSP_PVOC_POLAR_CONVERSION_H_
@@ -0,0 +1,376 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Real-input FFT, computed with a complex FFT of half the size.
+//
+// The n real samples x are seen as n/2 complex samples z[k] = x[2k] +
+// i x[2k+1], stored as two arrays (real parts in the first half of the
+// buffer, imaginary parts in the second half). The spectrum of x is
+// recovered from the spectrum of z by pairing the bins k and n/2 - k, and
+// it lands exactly in the packed layout of ShyFFT: no copy is needed
+// besides the bit-reversed one which feeds the butterflies.
+
+#include "supercell/dsp/pvoc/real_fft.h"
+
+#include "supercell/resources.h"
+
+namespace clouds {
+
+// Index of pi / 2 in lut_fft_cos, which covers a quarter of a period of
+// max_size samples.
+const size_t kFftQuarterPeriod = LUT_FFT_COS_SIZE - 1;
+
+/* static */
+inline void RealFFT::Twiddle(size_t index, float* c, float* s) {
+  // cos and sin of 2 pi index / max_size, index in [0, 3 max_size / 4].
+  const float* t = lut_fft_cos;
+  if (index <= kFftQuarterPeriod) {
+    *c = t[index];
+    *s = t[kFftQuarterPeriod - index];
+  } else if (index <= 2 * kFftQuarterPeriod) {
+    *c = -t[2 * kFftQuarterPeriod - index];
+    *s = t[index - kFftQuarterPeriod];
+  } else {
+    *c = -t[index - 2 * kFftQuarterPeriod];
+    *s = -t[3 * kFftQuarterPeriod - index];
+  }
+}
+
+// Radix-4 decimation in time. With an odd number of passes, a radix-2 pass
+// comes first.
+/* static */
+void RealFFT::DirectComplexPass(
+    float* re,
+    float* im,
+    size_t num_passes,
+    size_t pass) {
+  size_t size = static_cast<size_t>(1) << num_passes;
+  size_t length;
+  if (num_passes & 1) {
+    if (pass == 0) {
+      for (size_t i = 0; i < size; i += 2) {
+        float r = re[i + 1];
+        float j = im[i + 1];
+        re[i + 1] = re[i] - r;
+        im[i + 1] = im[i] - j;
+        re[i] += r;
+        im[i] += j;
+      }
+      return;
+    }
+    length = static_cast<size_t>(2) << (2 * (pass - 1));
+  } else {
+    length = static_cast<size_t>(1) << (2 * pass);
+  }
+
+  // Each pass combines 4 consecutive transforms of length q. Because of the
+  // bit-reversed ordering, they are the transforms of the samples 4k, 4k + 2,
+  // 4k + 1 and 4k + 3.
+  size_t q = length;
+  size_t stride = max_size / (q << 2);
+  for (size_t k = 0; k < q; ++k) {
+    float c1, s1, c2, s2, c3, s3;
+    Twiddle(k * stride, &c1, &s1);
+    Twiddle(2 * k * stride, &c2, &s2);
+    Twiddle(3 * k * stride, &c3, &s3);
+    for (size_t i0 = k; i0 < size; i0 += q << 2) {
+      size_t i1 = i0 + q;
+      size_t i2 = i1 + q;
+      size_t i3 = i2 + q;
+      float a0r = re[i0];
+      float a0i = im[i0];
+      float a2r = re[i1] * c2 + im[i1] * s2;
+      float a2i = im[i1] * c2 - re[i1] * s2;
+      float a1r = re[i2] * c1 + im[i2] * s1;
+      float a1i = im[i2] * c1 - re[i2] * s1;
+      float a3r = re[i3] * c3 + im[i3] * s3;
+      float a3i = im[i3] * c3 - re[i3] * s3;
+
+      float t0r = a0r + a2r;
+      float t0i = a0i + a2i;
+      float t1r = a0r - a2r;
+      float t1i = a0i - a2i;
+      float t2r = a1r + a3r;
+      float t2i = a1i + a3i;
+      float t3r = a1r - a3r;
+      float t3i = a1i - a3i;
+
+      re[i0] = t0r + t2r;
+      im[i0] = t0i + t2i;
+      re[i1] = t1r + t3i;
+      im[i1] = t1i - t3r;
+      re[i2] = t0r - t2r;
+      im[i2] = t0i - t2i;
+      re[i3] = t1r - t3i;
+      im[i3] = t1i + t3r;
+    }
+  }
+}
+
+/* static */
+void RealFFT::DirectComplex(float* re, float* im, size_t num_passes) {
+  for (size_t pass = 0; pass < num_complex_passes(num_passes); ++pass) {
+    DirectComplexPass(re, im, num_passes, pass);
+  }
+}
+
+// Radix-4 decimation in frequency. With an odd number of passes, a radix-2
+// pass comes last.
+/* static */
+void RealFFT::InverseComplexPass(
+    float* re,
+    float* im,
+    size_t num_passes,
+    size_t pass) {
+  size_t size = static_cast<size_t>(1) << num_passes;
+  if (pass == num_passes >> 1) {
+    for (size_t i = 0; i < size; i += 2) {
+      float r = re[i + 1];
+      float j = im[i + 1];
+      re[i + 1] = re[i] - r;
+      im[i + 1] = im[i] - j;
+      re[i] += r;
+      im[i] += j;
+    }
+    return;
+  }
+
+  size_t length = size >> (2 * pass);
+  size_t q = length >> 2;
+  size_t stride = max_size / length;
+  for (size_t k = 0; k < q; ++k) {
+    float c1, s1, c2, s2, c3, s3;
+    Twiddle(k * stride, &c1, &s1);
+    Twiddle(2 * k * stride, &c2, &s2);
+    Twiddle(3 * k * stride, &c3, &s3);
+    for (size_t i0 = k; i0 < size; i0 += length) {
+      size_t i1 = i0 + q;
+      size_t i2 = i1 + q;
+      size_t i3 = i2 + q;
+      float t0r = re[i0] + re[i2];
+      float t0i = im[i0] + im[i2];
+      float t1r = re[i0] - re[i2];
+      float t1i = im[i0] - im[i2];
+      float t2r = re[i1] + re[i3];
+      float t2i = im[i1] + im[i3];
+      float t3r = re[i1] - re[i3];
+      float t3i = im[i1] - im[i3];
+
+      re[i0] = t0r + t2r;
+      im[i0] = t0i + t2i;
+
+      float r = t0r - t2r;
+      float j = t0i - t2i;
+      re[i1] = r * c2 - j * s2;
+      im[i1] = r * s2 + j * c2;
+
+      r = t1r - t3i;
+      j = t1i + t3r;
+      re[i2] = r * c1 - j * s1;
+      im[i2] = r * s1 + j * c1;
+
+      r = t1r + t3i;
+      j = t1i - t3r;
+      re[i3] = r * c3 - j * s3;
+      im[i3] = r * s3 + j * c3;
+    }
+  }
+}
+
+/* static */
+void RealFFT::InverseComplex(float* re, float* im, size_t num_passes) {
+  for (size_t pass = 0; pass < num_complex_passes(num_passes); ++pass) {
+    InverseComplexPass(re, im, num_passes, pass);
+  }
+}
+
+/* static */
+size_t RealFFT::BitReversedIndex(size_t index, size_t num_passes) {
+  size_t reversed = 0;
+  for (size_t i = 0; i < num_passes; ++i) {
+    reversed = (reversed << 1) | (index & 1);
+    index >>= 1;
+  }
+  return reversed;
+}
+
+// With Z the transform of a + ib: A[k] = (Z[k] + conj(Z[n - k])) / 2 and
+// B[k] = (Z[k] - conj(Z[n - k])) / 2i. The bins k and n/2 - k are processed
+// together, since the values they read are the values they write. The DC
+// and Nyquist bins of A and B are already in place.
+/* static */
+void RealFFT::SplitSpectra(float* a, float* b, size_t size) {
+  size_t half = size >> 1;
+  for (size_t k = 1; k <= half >> 1; ++k) {
+    size_t bins[2] = { k, half - k };
+    float zr[2], zi[2], zr_mirror[2], zi_mirror[2];
+    for (size_t j = 0; j < 2; ++j) {
+      zr[j] = a[bins[j]];
+      zi[j] = b[bins[j]];
+      zr_mirror[j] = a[size - bins[j]];
+      zi_mirror[j] = b[size - bins[j]];
+    }
+    for (size_t j = 0; j < 2; ++j) {
+      a[bins[j]] = 0.5f * (zr[j] + zr_mirror[j]);
+      a[half + bins[j]] = 0.5f * (zi[j] - zi_mirror[j]);
+      b[bins[j]] = 0.5f * (zi[j] + zi_mirror[j]);
+      b[half + bins[j]] = 0.5f * (zr_mirror[j] - zr[j]);
+    }
+  }
+}
+
+// Z[k] = A[k] + iB[k] and Z[n - k] = conj(A[k]) + i conj(B[k]).
+/* static */
+void RealFFT::MergeSpectra(float* a, float* b, size_t size) {
+  size_t half = size >> 1;
+  for (size_t k = 1; k <= half >> 1; ++k) {
+    size_t bins[2] = { k, half - k };
+    float ar[2], ai[2], br[2], bi[2];
+    for (size_t j = 0; j < 2; ++j) {
+      ar[j] = a[bins[j]];
+      ai[j] = a[half + bins[j]];
+      br[j] = b[bins[j]];
+      bi[j] = b[half + bins[j]];
+    }
+    for (size_t j = 0; j < 2; ++j) {
+      a[bins[j]] = ar[j] - bi[j];
+      b[bins[j]] = ai[j] + br[j];
+      a[size - bins[j]] = ar[j] + bi[j];
+      b[size - bins[j]] = br[j] - ai[j];
+    }
+  }
+}
+
+void RealFFT::DirectStep(
+    const float* input,
+    float* output,
+    size_t num_passes,
+    size_t step) {
+  size_t size = static_cast<size_t>(1) << (num_passes - 1);
+  size_t num_butterfly_passes = num_complex_passes(num_passes - 1);
+  float* re = &output[0];
+  float* im = &output[size];
+
+  if (step == 0) {
+    size_t reversed = 0;
+    for (size_t i = 0; i < size; ++i) {
+      re[i] = input[2 * reversed];
+      im[i] = input[2 * reversed + 1];
+      reversed = NextBitReversedIndex(reversed, size);
+    }
+    return;
+  } else if (step <= num_butterfly_passes) {
+    DirectComplexPass(re, im, num_passes - 1, step - 1);
+    return;
+  }
+
+  // DC and Nyquist bins, both real.
+  float z0r = re[0];
+  float z0i = im[0];
+  re[0] = z0r + z0i;
+  re[size] = z0r - z0i;
+
+  // X[k] = E[k] + W^k O[k] and X[n/2 - k] = conj(E[k] - W^k O[k]), with
+  // E[k] = (Z[k] + conj(Z[n/2 - k])) / 2,
+  // O[k] = (Z[k] - conj(Z[n/2 - k])) / 2i.
+  size_t stride = max_size / (size << 1);
+  for (size_t k = 1, l = size - 1; k <= l; ++k, --l) {
+    float c, s;
+    Twiddle(k * stride, &c, &s);
+    float er = 0.5f * (re[k] + re[l]);
+    float ei = 0.5f * (im[k] - im[l]);
+    float or_ = 0.5f * (im[k] + im[l]);
+    float oi = 0.5f * (re[l] - re[k]);
+    float tr = c * or_ + s * oi;
+    float ti = c * oi - s * or_;
+    re[k] = er + tr;
+    im[k] = ei + ti;
+    re[l] = er - tr;
+    im[l] = ti - ei;
+  }
+}
+
+void RealFFT::Direct(const float* input, float* output, size_t num_passes) {
+  for (size_t step = 0; step < num_steps(num_passes); ++step) {
+    DirectStep(input, output, num_passes, step);
+  }
+}
+
+void RealFFT::InverseStep(
+    float* input,
+    float* output,
+    size_t num_passes,
+    size_t step) {
+  size_t size = static_cast<size_t>(1) << (num_passes - 1);
+  size_t num_butterfly_passes = num_complex_passes(num_passes - 1);
+  float* re = &input[0];
+  float* im = &input[size];
+
+  if (step == 0) {
+    // Z[k] = E[k] + i O[k], with E[k] = X[k] + conj(X[n/2 - k]) and
+    // O[k] = (X[k] - conj(X[n/2 - k])) W^-k. The factor of 2 compensates for
+    // the complex transform having half the size.
+    float x0 = re[0];
+    float xn = re[size];
+    re[0] = x0 + xn;
+    im[0] = x0 - xn;
+
+    size_t stride = max_size / (size << 1);
+    for (size_t k = 1, l = size - 1; k <= l; ++k, --l) {
+      float c, s;
+      Twiddle(k * stride, &c, &s);
+      float er = re[k] + re[l];
+      float ei = im[k] - im[l];
+      float dr = re[k] - re[l];
+      float di = im[k] + im[l];
+      float or_ = c * dr - s * di;
+      float oi = c * di + s * dr;
+      re[k] = er - oi;
+      im[k] = ei + or_;
+      re[l] = er + oi;
+      im[l] = or_ - ei;
+    }
+    return;
+  } else if (step <= num_butterfly_passes) {
+    InverseComplexPass(re, im, num_passes - 1, step - 1);
+    return;
+  }
+
+  size_t reversed = 0;
+  for (size_t i = 0; i < size; ++i) {
+    output[2 * i] = re[reversed];
+    output[2 * i + 1] = im[reversed];
+    reversed = NextBitReversedIndex(reversed, size);
+  }
+}
+
+void RealFFT::Inverse(float* input, float* output, size_t num_passes) {
+  for (size_t step = 0; step < num_steps(num_passes); ++step) {
+    InverseStep(input, output, num_passes, step);
+  }
+}
+
+}  // namespace clouds
@@ -0,0 +1,140 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Real-input FFT, computed with a complex FFT of half the size.
+//
+// Input and output layouts, sign and scaling are those the STFT expects from
+// ShyFFT, so that the two can be swapped: the spectrum is packed as
+// re[0..n/2] followed by im[1..n/2-1], and neither direction is normalized
+// (clouds_fft_benchmark checks both backends against a reference DFT). The
+// complex transform is also exposed, for the stereo STFT which transforms
+// both channels at once.
+
+#ifndef CLOUDS_DSP_PVOC_REAL_FFT_H_
+#define CLOUDS_DSP_PVOC_REAL_FFT_H_
+
+#include "stmlib/stmlib.h"
+
+namespace clouds {
+
+class RealFFT {
+ public:
+  RealFFT() { }
+  ~RealFFT() { }
+
+  // Largest size covered by the twiddle table (lut_fft_cos).
+  enum {
+    max_size = 4096,
+    max_num_passes = 12
+  };
+
+  void Init() { }
+
+  // The n/2 samples of the complex input are read from input in bit-reversed
+  // order, and the butterflies run in place in output. input is not modified.
+  void Direct(const float* input, float* output, size_t num_passes);
+
+  // The butterflies run in place in input, which is lost; the complex result
+  // is written to output in natural order.
+  void Inverse(float* input, float* output, size_t num_passes);
+
+  inline void Direct(const float* input, float* output) {
+    Direct(input, output, max_num_passes);
+  }
+
+  inline void Inverse(float* input, float* output) {
+    Inverse(input, output, max_num_passes);
+  }
+
+  // Direct() and Inverse() as a sequence of num_steps() steps - the
+  // reordering of the samples, each radix-4 (or radix-2) pass of the
+  // butterflies, and the separation of the real spectrum - for callers which
+  // spread a transform over several calls. The steps must be run in order,
+  // on the same buffers.
+  static inline size_t num_steps(size_t num_passes) {
+    return num_complex_passes(num_passes - 1) + 2;
+  }
+  void DirectStep(
+      const float* input,
+      float* output,
+      size_t num_passes,
+      size_t step);
+  void InverseStep(
+      float* input,
+      float* output,
+      size_t num_passes,
+      size_t step);
+
+  // In-place complex transforms of 2^num_passes points (up to max_size), with
+  // the real and imaginary parts in separate arrays. DirectComplex reads its
+  // input in bit-reversed order and writes its output in natural order;
+  // InverseComplex does the opposite. The callers do the permutation as they
+  // fill or read the arrays.
+  static void DirectComplex(float* re, float* im, size_t num_passes);
+  static void InverseComplex(float* re, float* im, size_t num_passes);
+
+  // The passes of the butterflies of DirectComplex and InverseComplex, which
+  // can be run one at a time, in order.
+  static inline size_t num_complex_passes(size_t num_passes) {
+    return (num_passes + 1) >> 1;
+  }
+  static void DirectComplexPass(
+      float* re,
+      float* im,
+      size_t num_passes,
+      size_t pass);
+  static void InverseComplexPass(
+      float* re,
+      float* im,
+      size_t num_passes,
+      size_t pass);
+
+  // Two real signals a and b of size points, transformed together as a + ib,
+  // are separated into two spectra in the packed layout above, in place.
+  // MergeSpectra is the reverse operation, before the inverse transform.
+  static void SplitSpectra(float* a, float* b, size_t size);
+  static void MergeSpectra(float* a, float* b, size_t size);
+
+  static size_t BitReversedIndex(size_t index, size_t num_passes);
+
+  static inline size_t NextBitReversedIndex(size_t reversed, size_t size) {
+    size_t bit = size >> 1;
+    while (reversed & bit) {
+      reversed ^= bit;
+      bit >>= 1;
+    }
+    return reversed | bit;
+  }
+
+ private:
+  static inline void Twiddle(size_t index, float* c, float* s);
+
+  DISALLOW_COPY_AND_ASSIGN(RealFFT);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_DSP_PVOC_REAL_FFT_H_
@@ -33,24 +33,24 @@
 #include <cstring>
 #include <numeric>
 
-#include "stmlib/dsp/atan.h"
 #include "stmlib/dsp/units.h"
-#include "stmlib/utils/random.h"
 
 #include "supercell/dsp/frame.h"
 #include "supercell/dsp/parameters.h"
+#include "supercell/dsp/pvoc/polar_conversion.h"
 
 namespace clouds {
 
 using namespace std;
 using namespace stmlib;
 
-static const size_t kMaxFilterBankBands = 128;
 static const size_t kMaxRandTriggerValue = 30;
 
 void SpectralCloudsTransformation::Init(float* buffer, int32_t fft_size,
-		int32_t num_textures, float sample_rate_hz, FFT* fft) {
+		int32_t num_textures, float sample_rate_hz, FFT* fft,
+		RandomGenerator* random) {
 	fft_ = fft;
+	random_ = random;
 	size_ = fft_size / 2;
 
 	for (int32_t i = 0; i < num_textures; ++i) {
@@ -59,13 +59,16 @@ void SpectralCloudsTransformation::Init(float* buffer, int32_t fft_size,
 	phases_ = static_cast<uint16_t*>((void*) (buffers_[num_textures - 1]));
 	previous_mag_ = phases_ + size_;
 
-	band_gain_target_ = static_cast<uint16_t*>((void*) (buffers_[num_textures
-			- 2]));
-	band_gain_state_ = band_gain_target_ + size_;
-
-	current_num_freq_bands_parameter_ = 1.0f;
+	band_gain_state_ = buffers_[num_textures - 2];
+	band_gain_target_ = static_cast<uint16_t*>((void*) (
+			&band_gain_state_[kMaxFilterBankBands]));
+	current_num_freq_bands_parameter_ =
+			&band_gain_state_[kMaxFilterBankBands + kMaxFilterBankBands / 2];
 
 	Reset(num_textures);
+
+	*current_num_freq_bands_parameter_ = 1.0f;
+	Partition(*current_num_freq_bands_parameter_);
 }
 
 void SpectralCloudsTransformation::Reset(int32_t num_textures) {
@@ -96,7 +99,7 @@ void SpectralCloudsTransformation::Process(const Parameters& parameters,
 	bool rand_trigger =
 			rand_trigger_parameter < 0.1 ?
 					false :
-					(stmlib::Random::GetWord()
+					(random_->GetWord()
 							% static_cast<uint32_t>((1.0f
 									- rand_trigger_parameter)
 									* kMaxRandTriggerValue + 1) == 0);
@@ -106,19 +109,27 @@ void SpectralCloudsTransformation::Process(const Parameters& parameters,
 					0.0f : 0.9f + parameter_low_pass_parameter * 0.10f;
 
 	if (trigger || rand_trigger) {
-		for (size_t i = 0; i < kMaxFilterBankBands; ++i) {
-			band_gain_target_[i] =
-					static_cast<uint16_t>(stmlib::Random::GetWord() & 0xFFFFU);
+		uint32_t random[kRandomBlockSize];
+		for (size_t i = 0; i < kMaxFilterBankBands; i += kRandomBlockSize) {
+			random_->FillWords(random, kRandomBlockSize);
+			for (size_t j = 0; j < kRandomBlockSize; ++j) {
+				band_gain_target_[i + j] =
+						static_cast<uint16_t>(random[j] & 0xFFFFU);
+			}
 		}
 	}
 
-	for (size_t i = 0; i < kMaxFilterBankBands; ++i) {
+	const float target_gain = (1.0f - parameter_low_pass) / 65535.0f;
+	for (int32_t i = 0; i < kMaxFilterBankBands; ++i) {
 		band_gain_state_[i] = parameter_low_pass * band_gain_state_[i]
-				+ (1.0f - parameter_low_pass) * band_gain_target_[i];
+				+ target_gain * static_cast<float>(band_gain_target_[i]);
 	}
-	current_num_freq_bands_parameter_ = parameter_low_pass
-			* current_num_freq_bands_parameter_
+	*current_num_freq_bands_parameter_ = parameter_low_pass
+			* *current_num_freq_bands_parameter_
 			+ (1.0f - parameter_low_pass) * num_freq_bands_parameter;
+	if (*current_num_freq_bands_parameter_ != partition_parameter_) {
+		Partition(*current_num_freq_bands_parameter_);
+	}
 
 	float* magnitudes = &fft_out[0];
 	if (!freeze) {
@@ -142,32 +153,25 @@ void SpectralCloudsTransformation::Process(const Parameters& parameters,
 
 	int32_t amount = static_cast<int32_t>(phase_randomization_parameter
 			* 32768.0f);
-	for (int32_t i = 1; i < size_ - 1; ++i) {
-		phases_[i] += static_cast<int32_t>(stmlib::Random::GetSample()) * amount
-				>> 14;
+	int16_t random[kRandomBlockSize];
+	for (int32_t i = 1; i < size_ - 1; i += kRandomBlockSize) {
+		int32_t block_size = min(size_ - 1 - i, int32_t(kRandomBlockSize));
+		random_->FillSamples(random, block_size);
+		for (int32_t j = 0; j < block_size; ++j) {
+			phases_[i + j] += static_cast<int32_t>(random[j]) * amount >> 14;
+		}
 	}
-	size_t band_idx = 0;
-	const float base = Interpolate(lut_freq_log, current_num_freq_bands_parameter_, LUT_FREQ_LOG_SIZE-1);
-	float interval = base;
-	float remainder = interval;
-
-	float band_mag = static_cast<float>(band_gain_state_[band_idx])
-			/ static_cast<float>(0xFFFFU);
-
-	for (int i = 1; i < size_ - 1; ++i) {
-		float band_gain = (density_threshold > band_mag) ? 0.0f : band_mag;
-		static float kSqrt2 = 1.4142f;
-		band_gain *= kSqrt2;
-		magnitudes[i] *= band_gain;
-		remainder -= 1.0f;
-		if (remainder <= 0) {
-			++band_idx;
-			band_idx = band_idx % kMaxFilterBankBands;
-			interval *= base;
-			remainder = interval;
-			band_mag = static_cast<float>(band_gain_state_[band_idx])
-					/ static_cast<float>(0xFFFFU);
+	static const float kSqrt2 = 1.4142f;
+	int32_t start = 1;
+	for (int32_t band = 0; band < num_bands_; ++band) {
+		const float band_mag = band_gain_state_[band];
+		const float band_gain =
+				(density_threshold > band_mag) ? 0.0f : band_mag * kSqrt2;
+		const int32_t end = band_end_[band];
+		for (int32_t i = start; i < end; ++i) {
+			magnitudes[i] *= band_gain;
 		}
+		start = end;
 	}
 
 	PolarToRectangular(fft_out, ifft_in);
@@ -176,22 +180,38 @@ void SpectralCloudsTransformation::Process(const Parameters& parameters,
 	ifft_in[size_] = 0.0f;
 }
 
+void SpectralCloudsTransformation::Partition(float num_freq_bands_parameter) {
+	// Band i spans ceil(base^(i+1)) bins. With the smallest base, 80 bands
+	// cover the largest FFT.
+	const float base = Interpolate(lut_freq_log, num_freq_bands_parameter,
+			LUT_FREQ_LOG_SIZE - 1);
+	float interval = base;
+	int32_t end = 1;
+	num_bands_ = 0;
+	while (end < size_ - 1 && num_bands_ < kMaxFilterBankBands) {
+		if (interval < static_cast<float>(size_)) {
+			end = min(end + static_cast<int32_t>(ceilf(interval)), size_ - 1);
+		} else {
+			end = size_ - 1;
+		}
+		band_end_[num_bands_++] = end;
+		interval *= base;
+	}
+	partition_parameter_ = num_freq_bands_parameter;
+}
+
 void SpectralCloudsTransformation::RectangularToPolar(float* fft_data) {
 	float* real = &fft_data[0];
 	float* imag = &fft_data[size_];
 	float* magnitude = &fft_data[0];
-	for (int32_t i = 1; i < size_; ++i) {
-		phases_[i] = fast_atan2r(imag[i], real[i], &magnitude[i]);
-	}
+	ConvertToPolar(&real[1], &imag[1], &magnitude[1], &phases_[1], size_ - 1);
 }
 
 void SpectralCloudsTransformation::PolarToRectangular(float* mags,
 		float* fft_out) {
 	float* real = &fft_out[0];
 	float* imag = &fft_out[size_];
-	for (int32_t i = 1; i < size_; ++i) {
-		fast_p2r(mags[i], phases_[i], &real[i], &imag[i]);
-	}
+	ConvertToRectangular(&mags[1], &phases_[1], &real[1], &imag[1], size_ - 1);
 }
 
 }  // namespace clouds
@@ -33,6 +33,7 @@
 
 #include "supercell/dsp/pvoc/stft.h"
 #include "supercell/dsp/pvoc/modifier.h"
+#include "supercell/dsp/random_generator.h"
 #include "supercell/resources.h"
 
 namespace clouds {
@@ -47,8 +48,9 @@ public:
 	}
 
 	static const int32_t kMaxNumTextures = 7;
+	static const int32_t kMaxFilterBankBands = 128;
 
-	virtual uint32_t num_textures() const {
+	virtual uint32_t num_textures(size_t) const {
 		return kMaxNumTextures;
 	}
 	virtual uint32_t texture_size(size_t fft_size) const {
@@ -56,24 +58,26 @@ public:
 	}
 
 	virtual void Init(float* buffer, int32_t fft_size, int32_t num_textures,
-										float sample_rate_hz, FFT* fft);
+										float sample_rate_hz, FFT* fft, RandomGenerator* random);
+
+	// The last two textures: the low-pass filtered band gains, their targets
+	// and the number of bands, then the phases and magnitudes.
+	virtual void* snapshot(size_t* size) {
+		*size = size_ * 2 * sizeof(float);
+		return band_gain_state_;
+	}
 
 	virtual void Process(const Parameters& parameters, float* fft_out, float* ifft_in, bool trigger);
 
 private:
 	void Reset(int32_t num_textures);
+	void Partition(float num_freq_bands_parameter);
 	void RectangularToPolar(float* fft_data);
 	void PolarToRectangular(float* mags, float* fft_data);
 
 
-	inline void fast_p2r(float magnitude, uint16_t angle, float* re,
-			float* im) {
-		angle >>= 6;
-		*re = magnitude * lut_sin[angle + 256];
-		*im = magnitude * lut_sin[angle];
-	}
-
 	FFT* fft_;
+	RandomGenerator* random_;
 
 	int32_t size_;
 
@@ -82,9 +86,15 @@ private:
 	uint16_t* phases_;
 	uint16_t* previous_mag_;
 	uint16_t* band_gain_target_;
-	uint16_t* band_gain_state_;
-
-	float current_num_freq_bands_parameter_;
+	float* band_gain_state_;
+	// Low-pass filtered number of bands parameter, saved with the band gains.
+	float* current_num_freq_bands_parameter_;
+
+	// Bins of the bands, from bin 1: band i ends before bin band_end_[i].
+	// Rebuilt when the number of bands changes.
+	uint16_t band_end_[kMaxFilterBankBands];
+	int32_t num_bands_;
+	float partition_parameter_;
 
 	DISALLOW_COPY_AND_ASSIGN (SpectralCloudsTransformation);
 };
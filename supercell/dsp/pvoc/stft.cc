@@ -30,8 +30,10 @@
 
 #include <algorithm>
 
+#include "supercell/drivers/cycle_counter.h"
 #include "supercell/dsp/parameters.h"
 #include "supercell/dsp/pvoc/modifier.h"
+#include "supercell/dsp/pvoc/real_fft.h"
 #include "supercell/resources.h"
 #include "stmlib/dsp/dsp.h"
 
@@ -73,6 +75,8 @@ void STFT::Init(
   window_ = window_lut;
   window_stride_ = LUT_SINE_WINDOW_4096_SIZE / fft_size;
   modifier_ = modifier;
+  partner_ = NULL;
+  paired_ = false;
   
   parameters_ = NULL;
   
@@ -89,6 +93,8 @@ void STFT::Reset() {
   fill(&synthesis_[0], &synthesis_[buffer_size_], 0);
   ready_ = 0;
   done_ = 0;
+  stage_ = STAGE_WINDOW;
+  stage_ptr_ = 0;
 }
 
 void STFT::Process(
@@ -123,23 +129,122 @@ void STFT::Process(
   }
 }
 
-void STFT::Buffer() {
+bool STFT::Buffer(uint32_t start, uint32_t time_budget) {
   if (ready_ == done_) {
-    return;
+    return true;
   }
   
+  while (true) {
+    switch (stage_) {
+      case STAGE_WINDOW:
+        {
+          size_t end = min(stage_ptr_ + kSliceSize, fft_size_);
+          Window(stage_ptr_, end);
+          if (partner_) {
+            partner_->Window(stage_ptr_, end);
+          }
+          stage_ptr_ = end;
+          if (stage_ptr_ == fft_size_) {
+            stage_ = STAGE_DIRECT_TRANSFORM;
+            stage_ptr_ = 0;
+          }
+        }
+        break;
+        
+      case STAGE_DIRECT_TRANSFORM:
+        if (DirectTransform(stage_ptr_++)) {
+          stage_ = STAGE_MODIFY;
+          stage_ptr_ = 0;
+        }
+        break;
+        
+      case STAGE_MODIFY:
+        Modify();
+        stage_ = partner_ ? STAGE_MODIFY_PARTNER : STAGE_INVERSE_TRANSFORM;
+        break;
+
+      case STAGE_MODIFY_PARTNER:
+        partner_->Modify();
+        stage_ = STAGE_INVERSE_TRANSFORM;
+        break;
+        
+      case STAGE_INVERSE_TRANSFORM:
+        if (InverseTransform(stage_ptr_++)) {
+          stage_ = STAGE_OVERLAP_ADD;
+          stage_ptr_ = 0;
+        }
+        break;
+        
+      case STAGE_OVERLAP_ADD:
+        {
+          size_t end = min(stage_ptr_ + kSliceSize, fft_size_);
+          OverlapAdd(stage_ptr_, end);
+          if (partner_) {
+            partner_->OverlapAdd(stage_ptr_, end);
+          }
+          stage_ptr_ = end;
+          if (stage_ptr_ == fft_size_) {
+            stage_ = STAGE_WINDOW;
+            stage_ptr_ = 0;
+            NextHop();
+            if (partner_) {
+              partner_->NextHop();
+            }
+            return true;
+          }
+        }
+        break;
+    }
+    if (time_budget && CycleCounter::Read() - start >= time_budget) {
+      return false;
+    }
+  }
+}
+
+void STFT::Window(size_t start, size_t end) {
   // Copy block to FFT buffer and apply window.
-  size_t source_ptr = process_ptr_;
-  const float* w = window_;
-  for (size_t i = 0; i < fft_size_; ++i) {
-    fft_in_[i] = w[0] * analysis_[source_ptr];
+  size_t source_ptr = process_ptr_ + start;
+  if (source_ptr >= buffer_size_) {
+    source_ptr -= buffer_size_;
+  }
+  const float* w = window_ + start * window_stride_;
+  // When paired, the complex FFT expects its input in bit-reversed order.
+  size_t index = paired_
+      ? RealFFT::BitReversedIndex(start, fft_num_passes_)
+      : start;
+  for (size_t i = start; i < end; ++i) {
+    fft_in_[index] = w[0] * analysis_[source_ptr];
     ++source_ptr;
     if (source_ptr >= buffer_size_) {
       source_ptr -= buffer_size_;
     }
     w += window_stride_;
+    index = paired_
+        ? RealFFT::NextBitReversedIndex(index, fft_size_)
+        : index + 1;
   }
-  
+}
+
+void STFT::NextHop() {
+  ++done_;
+  process_ptr_ += hop_size_;
+  if (process_ptr_ >= buffer_size_) {
+    process_ptr_ -= buffer_size_;
+  }
+}
+
+bool STFT::DirectTransform(size_t step) {
+  if (partner_) {
+    // Transform both channels at once, in place, one pass at a time.
+    if (step < RealFFT::num_complex_passes(fft_num_passes_)) {
+      RealFFT::DirectComplexPass(
+          fft_in_, partner_->fft_in_, fft_num_passes_, step);
+      return false;
+    }
+    RealFFT::SplitSpectra(fft_in_, partner_->fft_in_, fft_size_);
+    return true;
+  }
+
   // Compute FFT. fft_in is lost.
 #ifdef USE_ARM_FFT
   arm_rfft_fast_f32(fft_, fft_in_, fft_out_, 0);
@@ -149,21 +254,41 @@ void STFT::Buffer() {
     fft_out_[i] = fft_in_[2 * i];
     fft_out_[i + fft_size_ / 2] = fft_in_[2 * i + 1];
   }
+  return true;
+#elif defined(USE_REAL_FFT)
+  fft_->DirectStep(fft_in_, fft_out_, fft_num_passes_, step);
+  return step + 1 == RealFFT::num_steps(fft_num_passes_);
 #else
   if (fft_size_ != FFT::max_size) {
     fft_->Direct(fft_in_, fft_out_, fft_num_passes_);
   } else {
     fft_->Direct(fft_in_, fft_out_);
   }
+  return true;
 #endif  // USE_ARM_FFT
+}
+
+void STFT::Modify() {
   // Process in the frequency domain.
   if (modifier_ != NULL && parameters_ != NULL) {
     modifier_->Process(*parameters_, &fft_out_[0], &ifft_in_[0], trigger_received_);
     trigger_received_ = false;
-  } else {
+  } else if (fft_out_ != ifft_in_) {
     copy(&fft_out_[0], &fft_out_[fft_size_], &ifft_in_[0]);
   }
-  
+}
+
+bool STFT::InverseTransform(size_t step) {
+  if (partner_) {
+    if (step == 0) {
+      RealFFT::MergeSpectra(ifft_in_, partner_->ifft_in_, fft_size_);
+      return false;
+    }
+    RealFFT::InverseComplexPass(
+        ifft_in_, partner_->ifft_in_, fft_num_passes_, step - 1);
+    return step == RealFFT::num_complex_passes(fft_num_passes_);
+  }
+
   // Compute IFFT. ifft_in is lost.
 #ifdef USE_ARM_FFT
   // Re-arrange data.
@@ -173,26 +298,44 @@ void STFT::Buffer() {
     ifft_in_[2 * i + 1] = ifft_out_[i + fft_size_ / 2];
   }
   arm_rfft_fast_f32(fft_, ifft_in_, ifft_out_, 1);
+  return true;
+#elif defined(USE_REAL_FFT)
+  fft_->InverseStep(ifft_in_, ifft_out_, fft_num_passes_, step);
+  return step + 1 == RealFFT::num_steps(fft_num_passes_);
 #else
   if (fft_size_ != FFT::max_size) {
     fft_->Inverse(ifft_in_, ifft_out_, fft_num_passes_);
   } else {
     fft_->Inverse(ifft_in_, ifft_out_);
   }
+  return true;
 #endif  // USE_ARM_FFT
-  
-  size_t destination_ptr = process_ptr_;
+}
+
+void STFT::OverlapAdd(size_t start, size_t end) {
+  size_t destination_ptr = process_ptr_ + start;
+  if (destination_ptr >= buffer_size_) {
+    destination_ptr -= buffer_size_;
+  }
 #ifdef USE_ARM_FFT
+  // Unlike the complex IFFT used for pairs, the CMSIS IFFT is normalized.
   float inverse_window_size = 1.0f / \
-      float(fft_size_ / hop_size_ >> 1);
+      float((paired_ ? fft_size_ * fft_size_ : fft_size_) / hop_size_ >> 1);
 #else
   float inverse_window_size = 1.0f / \
       float(fft_size_ * fft_size_ / hop_size_ >> 1);
 #endif  // USE_ARM_FFT
     
-  w = window_;
-  for (size_t i = 0; i < fft_size_; ++i) {
-    float s = ifft_out_[i] * w[0] * inverse_window_size;
+  const float* w = window_ + start * window_stride_;
+  // When paired, the complex IFFT leaves its output in bit-reversed order.
+  size_t index = paired_
+      ? RealFFT::BitReversedIndex(start, fft_num_passes_)
+      : start;
+  for (size_t i = start; i < end; ++i) {
+    float s = ifft_out_[index] * w[0] * inverse_window_size;
+    index = paired_
+        ? RealFFT::NextBitReversedIndex(index, fft_size_)
+        : index + 1;
     
     int32_t x = static_cast<int32_t>(s);
     if (i < fft_size_ - hop_size_) {
@@ -206,12 +349,6 @@ void STFT::Buffer() {
     }
     w += window_stride_;
   }
-
-  ++done_;
-  process_ptr_ += hop_size_;
-  if (process_ptr_ >= buffer_size_) {
-    process_ptr_ -= buffer_size_;
-  }
 }
 
 }  // namespace clouds
@@ -32,9 +32,12 @@
 #include "stmlib/stmlib.h"
 
 // #define USE_ARM_FFT
+// #define USE_REAL_FFT
 
-#ifdef USE_ARM_FFT
+#if defined(USE_ARM_FFT)
   #include <arm_math.h>
+#elif defined(USE_REAL_FFT)
+  #include "supercell/dsp/pvoc/real_fft.h"
 #else
   #include "stmlib/fft/shy_fft.h"
 #endif  // USE_ARM_FFT
@@ -45,8 +48,10 @@ struct Parameters;
 class Modifier;
 
 const size_t kMaxFftSize = 4096;
-#ifdef USE_ARM_FFT
+#if defined(USE_ARM_FFT)
   typedef arm_rfft_fast_instance_f32 FFT;
+#elif defined(USE_REAL_FFT)
+  typedef RealFFT FFT;
 #else
   typedef stmlib::ShyFFT<float, kMaxFftSize, stmlib::RotationPhasor> FFT;
 #endif  // USE_ARM_FFT
@@ -77,9 +82,56 @@ class STFT {
       size_t size,
       size_t stride);
 
-  void Buffer();
+  // Processes the pending hop, if any. The work is split in stages (window,
+  // FFT, modifier, IFFT, overlap-add - with one modifier stage per channel
+  // when paired), the window and overlap-add stages in slices of kSliceSize
+  // samples, and, when paired or with RealFFT, the FFT and IFFT stages in
+  // passes (see RealFFT::DirectStep). When time_budget is not zero, the call
+  // returns once time_budget ticks (see CycleCounter) have elapsed since
+  // start, and the next call resumes where this one stopped. Returns true
+  // when no hop is left half-processed. The budget is only checked between
+  // two steps, so a call can overrun it by the longest step: a modifier
+  // stage, or the whole transform of an unpaired STFT with ShyFFT and CMSIS,
+  // which cannot be interrupted.
+  bool Buffer(uint32_t start, uint32_t time_budget);
+
+  // Processes the pending hop, if any, in a single call.
+  inline void Buffer() {
+    Buffer(0, 0);
+  }
+
+  // Makes Buffer() process the hops of partner along with its own, with a
+  // single complex FFT/IFFT for both channels (the two signals are the real
+  // and imaginary parts of the transform). The complex transform is the one
+  // of RealFFT, whatever the FFT backend. Both STFTs must have the same size
+  // and hop, each must have been given a single buffer for its FFT and IFFT
+  // (the modifiers then run in place), and Buffer() must not be called on
+  // partner. The modifier of partner runs as a stage of its own.
+  inline void set_partner(STFT* partner) {
+    partner_ = partner;
+    paired_ = partner->paired_ = true;
+  }
   
  private:
+  enum Stage {
+    STAGE_WINDOW,
+    STAGE_DIRECT_TRANSFORM,
+    STAGE_MODIFY,
+    STAGE_MODIFY_PARTNER,
+    STAGE_INVERSE_TRANSFORM,
+    STAGE_OVERLAP_ADD
+  };
+
+  static const size_t kSliceSize = 512;
+
+  void Window(size_t start, size_t end);
+  // Run the given step of the transform, and return true after the last one.
+  bool DirectTransform(size_t step);
+  void Modify();
+  bool InverseTransform(size_t step);
+  void OverlapAdd(size_t start, size_t end);
+  void NextHop();
+
   FFT* fft_;
   size_t fft_size_;
   size_t fft_num_passes_;
@@ -102,10 +154,14 @@ class STFT {
   
   size_t ready_;
   size_t done_;
+  Stage stage_;
+  size_t stage_ptr_;
   
   const Parameters* parameters_;
   
   Modifier* modifier_;
+  STFT* partner_;
+  bool paired_;
   
   bool trigger_received_;
 
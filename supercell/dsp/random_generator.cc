@@ -0,0 +1,57 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Jump-ahead tables of the random number generator.
+
+#include "supercell/dsp/random_generator.h"
+
+namespace clouds {
+
+/* extern */
+const uint32_t lut_random_jump_a[kRandomBlockSize] = {
+  0x0019660d, 0x17385ca9, 0xaf490a95, 0x0979e791,
+  0xaa9d885d, 0xbf69fab9, 0x6e587165, 0xea890021,
+  0x823b27ad, 0x0eb4f1c9, 0x74275d35, 0xaf4fd9b1,
+  0xfa1393fd, 0xf3aa51d9, 0x3a739e05, 0x77520441,
+  0x27351d4d, 0x03e42ae9, 0x4c7003d5, 0xe3040fd1,
+  0xb0eb139d, 0x90158cf9, 0xab945ea5, 0x125b8c61,
+  0x1e0dc6ed, 0x711a8809, 0x996d7e75, 0xc45f09f1,
+  0xcf52873d, 0x9e082c19, 0x966d3345, 0x27b61881,
+};
+
+/* extern */
+const uint32_t lut_random_jump_c[kRandomBlockSize] = {
+  0x3c6ef35f, 0x47502932, 0xd1ccf6e9, 0xaaf95334,
+  0x6252e503, 0x9f2ec686, 0x57fe6c2d, 0xa3d95fa8,
+  0x81fdbee7, 0x94f0af1a, 0xcbf633b1, 0xbcd1195c,
+  0x9d23e50b, 0xe296f6ee, 0x01ba5175, 0x83c6b450,
+  0xb52dfb6f, 0x4fc9f202, 0x624f0979, 0xa509a484,
+  0x865ce613, 0x8aad3456, 0x667adfbd, 0x3f469df8,
+  0x032dc8f7, 0x43f391ea, 0xfbca9841, 0x9cbb94ac,
+  0x73fe081b, 0x22331ebe, 0x57d53705, 0x05abbca0,
+};
+
+}  // namespace clouds
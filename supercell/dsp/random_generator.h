@@ -0,0 +1,129 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Seedable random number generator, owned by each processor instance.
+//
+// Same linear congruential generator as stmlib::Random, but with its own
+// state - so that several processors can run side by side, and a given seed
+// always renders the same output. The Fill*() functions generate a block of
+// values at once: each value of the block is computed directly from the state
+// at the start of the block (x[n + k] = a^k x[n] + c_k), so there is no
+// dependency chain between them and the loop pipelines/vectorizes.
+
+#ifndef CLOUDS_DSP_RANDOM_GENERATOR_H_
+#define CLOUDS_DSP_RANDOM_GENERATOR_H_
+
+#include "stmlib/stmlib.h"
+
+namespace clouds {
+
+const size_t kRandomBlockSize = 32;
+
+// x[n + k + 1] = lut_random_jump_a[k] * x[n] + lut_random_jump_c[k].
+extern const uint32_t lut_random_jump_a[kRandomBlockSize];
+extern const uint32_t lut_random_jump_c[kRandomBlockSize];
+
+class RandomGenerator {
+ public:
+  RandomGenerator() { }
+  ~RandomGenerator() { }
+
+  // Same initial state as stmlib::Random.
+  static const uint32_t kDefaultSeed = 0x21;
+
+  inline void Init() {
+    state_ = kDefaultSeed;
+  }
+
+  inline void Seed(uint32_t seed) {
+    state_ = seed;
+  }
+
+  inline uint32_t state() const { return state_; }
+
+  inline uint32_t GetWord() {
+    state_ = state_ * 1664525L + 1013904223L;
+    return state_;
+  }
+
+  inline int16_t GetSample() {
+    return static_cast<int16_t>(GetWord() >> 16);
+  }
+
+  inline float GetFloat() {
+    return static_cast<float>(GetWord()) / 4294967296.0f;
+  }
+
+  // Each of these functions returns the same values as size calls to
+  // GetWord(), GetSample() or GetFloat().
+  inline void FillWords(uint32_t* out, size_t size) {
+    while (size) {
+      size_t block_size = size < kRandomBlockSize ? size : kRandomBlockSize;
+      uint32_t x = state_;
+      for (size_t i = 0; i < block_size; ++i) {
+        out[i] = lut_random_jump_a[i] * x + lut_random_jump_c[i];
+      }
+      state_ = out[block_size - 1];
+      out += block_size;
+      size -= block_size;
+    }
+  }
+
+  inline void FillSamples(int16_t* out, size_t size) {
+    uint32_t words[kRandomBlockSize];
+    while (size) {
+      size_t block_size = size < kRandomBlockSize ? size : kRandomBlockSize;
+      FillWords(words, block_size);
+      for (size_t i = 0; i < block_size; ++i) {
+        out[i] = static_cast<int16_t>(words[i] >> 16);
+      }
+      out += block_size;
+      size -= block_size;
+    }
+  }
+
+  inline void FillFloats(float* out, size_t size) {
+    uint32_t words[kRandomBlockSize];
+    while (size) {
+      size_t block_size = size < kRandomBlockSize ? size : kRandomBlockSize;
+      FillWords(words, block_size);
+      for (size_t i = 0; i < block_size; ++i) {
+        out[i] = static_cast<float>(words[i]) / 4294967296.0f;
+      }
+      out += block_size;
+      size -= block_size;
+    }
+  }
+
+ private:
+  uint32_t state_;
+
+  DISALLOW_COPY_AND_ASSIGN(RandomGenerator);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_DSP_RANDOM_GENERATOR_H_
@@ -27,8 +27,8 @@
 // Smoothed random oscillator
 
 #include "../resources.h"
-#include "stmlib/utils/random.h"
 #include "stmlib/dsp/dsp.h"
+#include "supercell/dsp/random_generator.h"
 
 #ifndef CLOUDS_RANDOM_OSCILLATOR_H_
 #define CLOUDS_RANDOM_OSCILLATOR_H_
@@ -43,9 +43,10 @@ namespace clouds
   {
   public:
 
-    void Init() {
+    void Init(RandomGenerator* random) {
+      random_ = random;
       value_ = 0.0f;
-      next_value_ = Random::GetFloat() * 2.0f - 1.0f;
+      next_value_ = random_->GetFloat() * 2.0f - 1.0f;
     }
 
     inline void set_slope(float slope) {
@@ -60,7 +61,7 @@ namespace clouds
         phase_--;
         value_ = next_value_;
         direction_ = !direction_;
-        float rnd = (1.0f - kOscillationMinimumGap) * Random::GetFloat() + kOscillationMinimumGap;
+        float rnd = (1.0f - kOscillationMinimumGap) * random_->GetFloat() + kOscillationMinimumGap;
         next_value_ = direction_ ?
           value_ + (1.0f - value_) * rnd :
           value_ - (1.0f + value_) * rnd;
@@ -71,6 +72,7 @@ namespace clouds
     }
 
   private:
+    RandomGenerator* random_;
     float phase_;
     float phase_increment_;
     float value_;
@@ -30,9 +30,10 @@
 #define CLOUDS_DSP_RESONESTOR_H_
 
 #include "stmlib/stmlib.h"
-#include "stmlib/utils/random.h"
 #include "stmlib/dsp/units.h"
+#include "supercell/dsp/frame.h"
 #include "supercell/dsp/fx/fx_engine.h"
+#include "supercell/dsp/random_generator.h"
 #include "supercell/resources.h"
 
 using namespace stmlib;
@@ -76,8 +77,9 @@ class Resonestor {
   Resonestor() { }
   ~Resonestor() { }
 
-  void Init(float* buffer) {
+  void Init(float* buffer, RandomGenerator* random) {
     engine_.Init(buffer);
+    random_ = random;
     for (int v=0; v<2; v++) {
       pitch_[v] = 0.0f;
       chord_[v] = 0.0f;
@@ -97,7 +99,7 @@ class Resonestor {
     freeze_ = previous_freeze_ = 0.0f;
     voice_ = false;
     for (int i=0; i<3; i++)
-      spread_delay_[i] = Random::GetFloat() * 3999;
+      spread_delay_[i] = random_->GetFloat() * 3999;
     burst_lp_.Init();
     rand_lp_.Init();
     rand_hp_.Init();
@@ -177,18 +179,22 @@ class Resonestor {
       burst_time_ *= 2.0f * burst_duration_;
 
       for (int i=0; i<3; i++)
-        spread_delay_[i] = Random::GetFloat() * (bd0.length - 1);
+        spread_delay_[i] = random_->GetFloat() * (bd0.length - 1);
     }
 
     rand_lp_.set_f_q<FREQUENCY_FAST>(distortion_[voice_] * 0.4f, 1.0f);
 
+    float noise[kMaxBlockSize];
+    random_->FillFloats(noise, size);
+    const float* n = noise;
+
     while (size--) {
       engine_.Start(&c);
 
       burst_time_--;
       float burst_gain = burst_time_ > 0.0f ? 1.0f : 0.0f;
 
-      float random = Random::GetFloat() * 2.0f - 1.0f;
+      float random = *n++ * 2.0f - 1.0f;
       /* burst noise generation */
       c.Read(random, burst_gain);
       // goes through comb and lp filters
@@ -352,6 +358,7 @@ class Resonestor {
  private:
   typedef FxEngine<16384, FORMAT_32_BIT> E;
   E engine_;
+  RandomGenerator* random_;
 
   /* parameters: */
   float feedback_[2];
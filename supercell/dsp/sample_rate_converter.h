@@ -31,10 +31,26 @@
 
 #include "stmlib/stmlib.h"
 
+#include <algorithm>
+
+#if defined(TEST) && defined(__SSE2__)
+  #include <emmintrin.h>
+  #define CLOUDS_SAMPLE_RATE_CONVERTER_SSE2
+#endif
+
 #include "supercell/dsp/frame.h"
 
 namespace clouds {
 
+// Polyphase FIR interpolation (ratio > 0) or decimation (ratio < 0) by an
+// integer factor, with any of the src_filter_1x_* filters.
+//
+// The input is appended to a linear history holding the last frames seen,
+// so the taps of an output are read from contiguous memory. The coefficients
+// are stored phase by phase: the coefficient of tap m of output phase p is
+// at coefficients_[m][p], zero where a phase has fewer taps. Each output
+// sums its taps in the same order, from the newest input frame to the
+// oldest, whatever the implementation.
 template<int32_t ratio, int32_t filter_size, const float* coefficients>
 class SampleRateConverter {
  public:
@@ -42,51 +58,143 @@ class SampleRateConverter {
   ~SampleRateConverter() { }
  
   void Init() {
-    for (int32_t i = 0; i < filter_size * 2; ++i) {
-      history_[i].l = history_[i].r = 0.0f;
+    std::fill(&history_[0].l, &history_[0].l + 2 * kHistorySize, 0.0f);
+    for (int32_t m = 0; m < kNumTaps; ++m) {
+      for (int32_t p = 0; p < kNumPhases; ++p) {
+        int32_t j = m * kNumPhases + p;
+        coefficients_[m][p] = j < filter_size ? coefficients[j] : 0.0f;
+      }
     }
-    std::copy(&coefficients[0], &coefficients[filter_size], &coefficients_[0]);
-    history_ptr_ = filter_size - 1;
   };
 
+  // input_size must be a multiple of the decimation factor.
   void Process(const FloatFrame* in, FloatFrame* out, size_t input_size) {
-    int32_t history_ptr = history_ptr_;
-    FloatFrame* history = history_;
-    const float scale = ratio < 0 ? 1.0f : float(ratio);
     while (input_size) {
-      int32_t consumed = ratio < 0 ? -ratio : 1;
-      for (int32_t i = 0; i < consumed; ++i) {
-        history[history_ptr + filter_size] = history[history_ptr] = *in++;
-        --input_size;
-        --history_ptr;
-        if (history_ptr < 0) {
-          history_ptr += filter_size;
+      size_t size = std::min(input_size, static_cast<size_t>(kChunkSize));
+      std::copy(&in[0], &in[size], &history_[kNumTaps - 1]);
+      out = ratio > 0 ? Interpolate(out, size) : Decimate(out, size);
+      std::copy(
+          &history_[size],
+          &history_[size + kNumTaps - 1],
+          &history_[0]);
+      in += size;
+      input_size -= size;
+    }
+  }
+ 
+ private:
+  enum {
+    kNumPhases = ratio > 0 ? ratio : 1,
+    kStride = ratio < 0 ? -ratio : 1,
+    // Taps per phase, which is also the number of input frames an output
+    // depends on.
+    kNumTaps = (filter_size + kNumPhases - 1) / kNumPhases,
+    kChunkSize = kMaxBlockSize * kStride,
+    kHistorySize = kNumTaps - 1 + kChunkSize
+  };
+
+  // kNumPhases outputs for each of the size frames at the end of the history.
+  FloatFrame* Interpolate(FloatFrame* out, size_t size) {
+    const float scale = static_cast<float>(kNumPhases);
+    size_t t = 0;
+#ifdef CLOUDS_SAMPLE_RATE_CONVERTER_SSE2
+    if (kNumPhases == 2) {
+      // The left and right channels of both phases, in the 4 lanes, for two
+      // input frames at a time.
+      const __m128 k = _mm_set1_ps(scale);
+      for (; t + 1 < size; t += 2) {
+        const FloatFrame* x = &history_[kNumTaps - 1 + t];
+        __m128 y_0 = _mm_setzero_ps();
+        __m128 y_1 = _mm_setzero_ps();
+        for (int32_t m = 0; m < kNumTaps; ++m) {
+          __m128 x_01 = _mm_loadu_ps(&x[-m].l);
+          __m128 h = _mm_loadl_pi(
+              _mm_setzero_ps(),
+              reinterpret_cast<const __m64*>(&coefficients_[m][0]));
+          h = _mm_unpacklo_ps(h, h);
+          y_0 = _mm_add_ps(y_0, _mm_mul_ps(_mm_movelh_ps(x_01, x_01), h));
+          y_1 = _mm_add_ps(y_1, _mm_mul_ps(_mm_movehl_ps(x_01, x_01), h));
         }
+        _mm_storeu_ps(&out[0].l, _mm_mul_ps(y_0, k));
+        _mm_storeu_ps(&out[2].l, _mm_mul_ps(y_1, k));
+        out += 4;
       }
-    
-      int32_t produced = ratio > 0 ? ratio : 1;
-      for (int32_t i = 0; i < produced; ++i) {
-        float y_l = 0.0f;
-        float y_r = 0.0f;
-        const FloatFrame* x = &history[history_ptr + 1];
-        for (int32_t j = i; j < filter_size; j += produced) {
-          const float h = coefficients_[j];
-          y_l += x->l * h;
-          y_r += x->r * h;
-          ++x;
+    }
+#endif  // CLOUDS_SAMPLE_RATE_CONVERTER_SSE2
+    for (; t < size; ++t) {
+      const FloatFrame* x = &history_[kNumTaps - 1 + t];
+      float y_l[kNumPhases];
+      float y_r[kNumPhases];
+      std::fill(&y_l[0], &y_l[kNumPhases], 0.0f);
+      std::fill(&y_r[0], &y_r[kNumPhases], 0.0f);
+      for (int32_t m = 0; m < kNumTaps; ++m) {
+        for (int32_t p = 0; p < kNumPhases; ++p) {
+          const float h = coefficients_[m][p];
+          y_l[p] += x[-m].l * h;
+          y_r[p] += x[-m].r * h;
         }
-        out->l = y_l * scale;
-        out->r = y_r * scale;
+      }
+      for (int32_t p = 0; p < kNumPhases; ++p) {
+        out->l = y_l[p] * scale;
+        out->r = y_r[p] * scale;
         ++out;
       }
     }
-    history_ptr_ = history_ptr;
+    return out;
   }
- 
- private:
-  float coefficients_[filter_size];
-  FloatFrame history_[filter_size * 2];
-  int32_t history_ptr_;
+
+  // One output for every kStride of the size frames at the end of the
+  // history, the last one being the newest frame of its window.
+  FloatFrame* Decimate(FloatFrame* out, size_t size) {
+    size_t t = kStride - 1;
+#ifdef CLOUDS_SAMPLE_RATE_CONVERTER_SSE2
+    if (kStride == 2) {
+      // The left and right channels of 4 successive outputs, two in the lanes
+      // of each accumulator. Only the frame of each output is loaded: the one
+      // after the last output is past the end of the history.
+      for (; t + 3 * kStride < size; t += 4 * kStride) {
+        const FloatFrame* x = &history_[kNumTaps - 1 + t];
+        __m128 y_0 = _mm_setzero_ps();
+        __m128 y_1 = _mm_setzero_ps();
+        for (int32_t m = 0; m < kNumTaps; ++m) {
+          __m128 h = _mm_load1_ps(&coefficients_[m][0]);
+          __m128 x_02 = _mm_loadh_pi(
+              _mm_loadl_pi(
+                  _mm_setzero_ps(),
+                  reinterpret_cast<const __m64*>(&x[-m].l)),
+              reinterpret_cast<const __m64*>(&x[2 - m].l));
+          __m128 x_46 = _mm_loadh_pi(
+              _mm_loadl_pi(
+                  _mm_setzero_ps(),
+                  reinterpret_cast<const __m64*>(&x[4 - m].l)),
+              reinterpret_cast<const __m64*>(&x[6 - m].l));
+          y_0 = _mm_add_ps(y_0, _mm_mul_ps(x_02, h));
+          y_1 = _mm_add_ps(y_1, _mm_mul_ps(x_46, h));
+        }
+        _mm_storeu_ps(&out[0].l, y_0);
+        _mm_storeu_ps(&out[2].l, y_1);
+        out += 4;
+      }
+    }
+#endif  // CLOUDS_SAMPLE_RATE_CONVERTER_SSE2
+    for (; t < size; t += kStride) {
+      const FloatFrame* x = &history_[kNumTaps - 1 + t];
+      float y_l = 0.0f;
+      float y_r = 0.0f;
+      for (int32_t m = 0; m < kNumTaps; ++m) {
+        const float h = coefficients_[m][0];
+        y_l += x[-m].l * h;
+        y_r += x[-m].r * h;
+      }
+      out->l = y_l;
+      out->r = y_r;
+      ++out;
+    }
+    return out;
+  }
+
+  float coefficients_[kNumTaps][kNumPhases];
+  FloatFrame history_[kHistorySize];
 
   DISALLOW_COPY_AND_ASSIGN(SampleRateConverter);
 };
@@ -64,6 +64,7 @@ extern const float lut_sine_window_4096[];
 extern const float lut_cutoff[];
 extern const float lut_grain_size[];
 extern const float lut_quantized_pitch[];
+extern const float lut_fft_cos[];
 #define SRC_FILTER_1X_2_31 0
 #define SRC_FILTER_1X_2_31_SIZE 31
 #define SRC_FILTER_1X_2_45 1
@@ -96,6 +97,8 @@ extern const float lut_quantized_pitch[];
 #define LUT_GRAIN_SIZE_SIZE 257
 #define LUT_QUANTIZED_PITCH 10
 #define LUT_QUANTIZED_PITCH_SIZE 1025
+#define LUT_FFT_COS 11
+#define LUT_FFT_COS_SIZE 1025
 
 }  // namespace clouds
 
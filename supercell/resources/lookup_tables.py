@@ -174,3 +174,13 @@ for i in xrange(n):
   pitch[start_index:end_index] = notches[i] + (notches[i + 1] - notches[i]) * xfade
 
 lookup_tables.append(('quantized_pitch', pitch))
+
+
+
+"""----------------------------------------------------------------------------
+Quarter of a cosine period, for the twiddle factors of the real FFT.
+----------------------------------------------------------------------------"""
+
+size = 4096
+t = numpy.arange(0, size / 4 + 1) / float(size) * numpy.pi * 2
+lookup_tables.append(('fft_cos', numpy.cos(t)))
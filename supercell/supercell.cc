@@ -24,6 +24,7 @@
 
 #include "supercell/cv_scaler.h"
 #include "supercell/drivers/codec.h"
+#include "supercell/drivers/cycle_counter.h"
 #include "supercell/drivers/debug_pin.h"
 #include "supercell/drivers/debug_port.h"
 #include "supercell/drivers/system.h"
@@ -112,6 +113,11 @@ void Init() {
   processor.Init(
       block_mem, sizeof(block_mem),
       block_ccm, sizeof(block_ccm));
+  processor.set_adaptive_grains(true);
+  // One complex FFT and IFFT per hop for both channels in stereo.
+  processor.set_paired_transforms(true);
+  // Keep the main loop responsive while a spectral frame is computed.
+  processor.set_prepare_time_budget(CycleCounter::kTicksPerSecond / 10000);
 
   settings.Init();
   cv_scaler.Init(settings.mutable_calibration_data());
@@ -144,5 +150,9 @@ int main(void) {
   while (1) {
     ui.DoEvents();
     processor.Prepare();
+#ifdef PROFILE_STAGES
+    // The per-stage statistics can be inspected with a debugger.
+    processor.mutable_profiler()->Poll();
+#endif  // PROFILE_STAGES
   }
 }
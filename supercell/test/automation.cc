@@ -0,0 +1,212 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Parameter automation for the host tools.
+
+#include "supercell/test/automation.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+namespace clouds {
+
+using namespace std;
+
+namespace {
+
+struct ParameterInfo {
+  const char* name;
+  size_t offset;
+  bool boolean;
+};
+
+#define FLOAT_PARAMETER(name, field) { name, offsetof(Parameters, field), false }
+#define BOOL_PARAMETER(name, field) { name, offsetof(Parameters, field), true }
+
+const ParameterInfo kParameters[] = {
+  FLOAT_PARAMETER("position", position),
+  FLOAT_PARAMETER("size", size),
+  FLOAT_PARAMETER("pitch", pitch),
+  FLOAT_PARAMETER("density", density),
+  FLOAT_PARAMETER("texture", texture),
+  FLOAT_PARAMETER("dry_wet", dry_wet),
+  FLOAT_PARAMETER("stereo_spread", stereo_spread),
+  FLOAT_PARAMETER("feedback", feedback),
+  FLOAT_PARAMETER("reverb", reverb),
+  BOOL_PARAMETER("freeze", freeze),
+  BOOL_PARAMETER("capture", capture),
+  BOOL_PARAMETER("gate", gate),
+  BOOL_PARAMETER("reverse", granular.reverse),
+  FLOAT_PARAMETER("kammerl.probability", kammerl.probability),
+  FLOAT_PARAMETER("kammerl.pitch_mode", kammerl.pitch_mode),
+  FLOAT_PARAMETER("kammerl.clock_divider", kammerl.clock_divider),
+  FLOAT_PARAMETER("kammerl.distortion", kammerl.distortion),
+  FLOAT_PARAMETER("kammerl.slice_selection", kammerl.slice_selection),
+  FLOAT_PARAMETER("kammerl.slice_modulation", kammerl.slice_modulation),
+  FLOAT_PARAMETER("kammerl.size_modulation", kammerl.size_modulation),
+  FLOAT_PARAMETER("kammerl.pitch", kammerl.pitch),
+};
+
+#undef FLOAT_PARAMETER
+#undef BOOL_PARAMETER
+
+const int kNumParameters = sizeof(kParameters) / sizeof(kParameters[0]);
+
+int FindParameter(const char* name) {
+  for (int i = 0; i < kNumParameters; ++i) {
+    if (!strcmp(kParameters[i].name, name)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void Write(int parameter, float value, Parameters* parameters) {
+  const ParameterInfo& info = kParameters[parameter];
+  uint8_t* p = reinterpret_cast<uint8_t*>(parameters) + info.offset;
+  if (info.boolean) {
+    *reinterpret_cast<bool*>(p) = value >= 0.5f;
+  } else {
+    *reinterpret_cast<float*>(p) = value;
+  }
+}
+
+}  // namespace
+
+bool Automation::Load(const char* file_name) {
+  FILE* fp = fopen(file_name, "r");
+  if (!fp) {
+    error_ = string("cannot open ") + file_name;
+    return false;
+  }
+  char line[256];
+  int line_number = 0;
+  bool success = true;
+  while (success && fgets(line, sizeof(line), fp)) {
+    success = Parse(line, ++line_number);
+  }
+  fclose(fp);
+  return success;
+}
+
+bool Automation::Parse(const char* line, int line_number) {
+  char buffer[256];
+  strncpy(buffer, line, sizeof(buffer) - 1);
+  buffer[sizeof(buffer) - 1] = '\0';
+  char* comment = strchr(buffer, '#');
+  if (comment) {
+    *comment = '\0';
+  }
+
+  char name[64];
+  float time, value;
+  char extra;
+  int num_fields = sscanf(buffer, "%f %63s %f %c", &time, name, &value, &extra);
+  if (num_fields <= 0) {
+    return true;  // Blank line or comment.
+  }
+  char message[128];
+  if (num_fields != 3 || time < 0.0f) {
+    sprintf(message, "line %d: expected <time> <parameter> <value>",
+        line_number);
+    error_ = message;
+    return false;
+  }
+  int parameter = FindParameter(name);
+  if (parameter == -1) {
+    sprintf(message, "line %d: unknown parameter ", line_number);
+    error_ = string(message) + name;
+    return false;
+  }
+
+  Track* track = NULL;
+  for (size_t i = 0; i < tracks_.size(); ++i) {
+    if (tracks_[i].parameter == parameter) {
+      track = &tracks_[i];
+    }
+  }
+  if (!track) {
+    tracks_.push_back(Track());
+    track = &tracks_.back();
+    track->parameter = parameter;
+    track->cursor = 0;
+  }
+  // Keep keyframes sorted; keyframes at the same time stay in file order.
+  Keyframe keyframe = { time, value };
+  vector<Keyframe>::iterator it = track->keyframes.end();
+  while (it != track->keyframes.begin() && (it - 1)->time > time) {
+    --it;
+  }
+  track->keyframes.insert(it, keyframe);
+  return true;
+}
+
+void Automation::Rewind() {
+  for (size_t i = 0; i < tracks_.size(); ++i) {
+    tracks_[i].cursor = 0;
+  }
+}
+
+void Automation::Apply(float t, Parameters* parameters) {
+  for (size_t i = 0; i < tracks_.size(); ++i) {
+    Track& track = tracks_[i];
+    const vector<Keyframe>& k = track.keyframes;
+    size_t n = k.size();
+    while (track.cursor + 1 < n && k[track.cursor + 1].time <= t) {
+      ++track.cursor;
+    }
+    const Keyframe& a = k[track.cursor];
+    float value = a.value;
+    if (!kParameters[track.parameter].boolean &&
+        track.cursor + 1 < n &&
+        t > a.time) {
+      const Keyframe& b = k[track.cursor + 1];
+      value += (b.value - a.value) * (t - a.time) / (b.time - a.time);
+    }
+    Write(track.parameter, value, parameters);
+  }
+}
+
+/* static */
+bool Automation::Set(const char* name, float value, Parameters* parameters) {
+  int parameter = FindParameter(name);
+  if (parameter == -1) {
+    return false;
+  }
+  Write(parameter, value, parameters);
+  return true;
+}
+
+/* static */
+void Automation::ListParameters(FILE* fp) {
+  for (int i = 0; i < kNumParameters; ++i) {
+    fprintf(fp, "  %s%s\n", kParameters[i].name,
+        kParameters[i].boolean ? " (boolean)" : "");
+  }
+}
+
+}  // namespace clouds
@@ -0,0 +1,97 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Parameter automation for the host tools.
+//
+// An automation file is a list of "<time in seconds> <parameter> <value>"
+// lines; blank lines and everything after a '#' are ignored. Continuous
+// parameters are linearly interpolated between their keyframes, booleans
+// (freeze, capture, gate, reverse...) switch at the keyframe time. Before its
+// first keyframe and after its last one, a parameter holds the nearest value.
+// Parameters which are not automated keep the value set by the caller.
+//
+//   0.0  position 0.2
+//   4.0  position 0.8
+//   2.5  freeze   1
+
+#ifndef CLOUDS_TEST_AUTOMATION_H_
+#define CLOUDS_TEST_AUTOMATION_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "stmlib/stmlib.h"
+
+#include "supercell/dsp/parameters.h"
+
+namespace clouds {
+
+class Automation {
+ public:
+  Automation() { }
+  ~Automation() { }
+
+  // Returns false and fills error() if the file cannot be read or parsed.
+  bool Load(const char* file_name);
+  bool Parse(const char* line, int line_number);
+
+  // Writes the automated values at time t into parameters. Calls are expected
+  // with non-decreasing times (the cursors only move forward), which makes a
+  // render linear in the number of keyframes.
+  void Apply(float t, Parameters* parameters);
+
+  // Rewinds the cursors, to render again from t = 0.
+  void Rewind();
+
+  inline bool empty() const { return tracks_.empty(); }
+  inline const std::string& error() const { return error_; }
+
+  // Sets a single parameter by name, returns false if the name is unknown.
+  static bool Set(const char* name, float value, Parameters* parameters);
+  static void ListParameters(FILE* fp);
+
+ private:
+  struct Keyframe {
+    float time;
+    float value;
+  };
+
+  struct Track {
+    int parameter;
+    size_t cursor;
+    std::vector<Keyframe> keyframes;
+  };
+
+  std::vector<Track> tracks_;
+  std::string error_;
+
+  DISALLOW_COPY_AND_ASSIGN(Automation);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_TEST_AUTOMATION_H_
@@ -0,0 +1,144 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Batch renderer: renders a list of jobs on all the cores of the machine.
+//
+// clouds_batch [-j threads] jobs.txt
+//
+// Each line of the job list is an input file, an output file and optional
+// key=value settings, as accepted by clouds_render:
+//
+//   # input         output              settings
+//   drums.wav       drums_spectral.wav  mode=spectral quality=1 texture=0.8
+//   pad.wav         pad_frozen.wav      mode=granular automation=pad.txt
+//
+// Blank lines and everything after a '#' are ignored.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "supercell/test/render_engine.h"
+
+using namespace clouds;
+using namespace std;
+
+bool LoadJobs(const char* file_name, vector<RenderJob>* jobs) {
+  FILE* fp = fopen(file_name, "r");
+  if (!fp) {
+    fprintf(stderr, "Cannot open %s\n", file_name);
+    return false;
+  }
+  char line[1024];
+  int line_number = 0;
+  bool success = true;
+  while (success && fgets(line, sizeof(line), fp)) {
+    ++line_number;
+    char* comment = strchr(line, '#');
+    if (comment) {
+      *comment = '\0';
+    }
+    RenderJob job;
+    int num_tokens = 0;
+    for (char* token = strtok(line, " \t\r\n");
+         token;
+         token = strtok(NULL, " \t\r\n")) {
+      if (num_tokens == 0) {
+        job.input = token;
+      } else if (num_tokens == 1) {
+        job.output = token;
+      } else if (!job.Set(token)) {
+        fprintf(stderr, "%s:%d: invalid setting %s\n",
+            file_name, line_number, token);
+        success = false;
+      }
+      ++num_tokens;
+    }
+    if (num_tokens == 1) {
+      fprintf(stderr, "%s:%d: missing output file\n", file_name, line_number);
+      success = false;
+    } else if (num_tokens) {
+      jobs->push_back(job);
+    }
+  }
+  fclose(fp);
+  return success;
+}
+
+void PrintProgress(
+    size_t index,
+    const RenderJob& job,
+    const RenderResult& result,
+    void* context) {
+  size_t* num_done = static_cast<size_t*>(context);
+  ++*num_done;
+  fprintf(stderr, "[%zu] #%zu %s -> %s: %s (%.2fs, thread %zu)%s%s\n",
+      *num_done, index + 1, job.input.c_str(), job.output.c_str(),
+      result.success ? "ok" : "FAILED", result.seconds, result.worker,
+      result.message.empty() ? "" : " ", result.message.c_str());
+}
+
+int main(int argc, char** argv) {
+  long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int option;
+  while ((option = getopt(argc, argv, "j:h")) != -1) {
+    switch (option) {
+      case 'j':
+        num_threads = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-j threads] jobs.txt\n", argv[0]);
+        return option == 'h' ? 0 : 1;
+    }
+  }
+  if (argc - optind != 1) {
+    fprintf(stderr, "Usage: %s [-j threads] jobs.txt\n", argv[0]);
+    return 1;
+  }
+
+  vector<RenderJob> jobs;
+  if (!LoadJobs(argv[optind], &jobs)) {
+    return 1;
+  }
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+  if (static_cast<size_t>(num_threads) > jobs.size()) {
+    num_threads = jobs.empty() ? 1 : jobs.size();
+  }
+
+  RenderEngine engine;
+  engine.Init(num_threads);
+  vector<RenderResult> results;
+  size_t num_done = 0;
+  size_t num_failures = engine.Render(jobs, &results, &PrintProgress, &num_done);
+  fprintf(stderr, "%zu jobs, %zu failed, %ld threads\n",
+      jobs.size(), num_failures, num_threads);
+  return num_failures ? 1 : 0;
+}
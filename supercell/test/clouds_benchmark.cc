@@ -0,0 +1,368 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Microbenchmark of GranularProcessor::Process() and Prepare().
+//
+// Every playback mode is run at the four quality settings on a synthetic
+// input, with the same slow sweeps of all the parameters, in blocks of 32
+// samples - as in the firmware. For each configuration, the following is
+// reported:
+//   - the average Process() time per sample,
+//   - the worst Process() time for a block,
+//   - the average and worst Prepare() time per block (the FFT/IFFT of the
+//     spectral modes run there),
+//   - the worst Process() + Prepare() time for a block, as a percentage of
+//     the real-time budget of a block (1ms), host time.
+//
+// When built with PROFILE_STAGES=TRUE, -s also prints the time spent in each
+// stage of Process() (the profiler itself adds a small overhead).
+//
+// The results can be written to a CSV baseline, and compared with a previous
+// baseline; the program then fails if a configuration got slower by more than
+// the tolerance.
+//
+// -l prints the layout of the delay memory of the effects instead: the memory
+// used and left, and the base and length of each delay line, in samples.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <xmmintrin.h>
+
+#include "supercell/dsp/fx/diffuser.h"
+#include "supercell/dsp/fx/pitch_shifter.h"
+#include "supercell/dsp/fx/reverb.h"
+#include "supercell/test/corpus.h"
+#include "supercell/test/renderer.h"
+
+using namespace clouds;
+using namespace std;
+
+const size_t kBlockSize = 32;
+const double kBlockBudgetNs = 1e9 * kBlockSize / kSampleRate;
+
+struct Result {
+  string name;
+  double process_ns_per_sample;
+  double process_worst_ns;
+  double prepare_ns;
+  double prepare_worst_ns;
+  double block_worst_ns;
+};
+
+inline uint64_t Now() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return static_cast<uint64_t>(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+Result Run(
+    Renderer* renderer,
+    PlaybackMode mode,
+    int32_t quality,
+    const vector<ShortFrame>& input) {
+  renderer->Init(mode, quality, kBlockSize, RandomGenerator::kDefaultSeed);
+  GranularProcessor* processor = renderer->processor();
+  Parameters* parameters = processor->mutable_parameters();
+
+  uint64_t process_total = 0;
+  uint64_t prepare_total = 0;
+  uint64_t process_worst = 0;
+  uint64_t prepare_worst = 0;
+  uint64_t block_worst = 0;
+  size_t num_blocks = input.size() / kBlockSize;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    ShortFrame in[kBlockSize];
+    ShortFrame out[kBlockSize];
+    memcpy(in, &input[i * kBlockSize], sizeof(in));
+    SweepParameters(
+        static_cast<float>(i * kBlockSize) / kSampleRate, parameters);
+
+    uint64_t start = Now();
+    processor->Process(in, out, kBlockSize);
+    uint64_t middle = Now();
+    processor->Prepare();
+    uint64_t end = Now();
+#ifdef PROFILE_STAGES
+    processor->mutable_profiler()->Poll();
+#endif  // PROFILE_STAGES
+
+    uint64_t process = middle - start;
+    uint64_t prepare = end - middle;
+    process_total += process;
+    prepare_total += prepare;
+    process_worst = max(process_worst, process);
+    prepare_worst = max(prepare_worst, prepare);
+    block_worst = max(block_worst, process + prepare);
+  }
+
+  Result r;
+  char name[64];
+  sprintf(name, "%s/q%d", Renderer::playback_mode_name(mode), quality);
+  r.name = name;
+  r.process_ns_per_sample = static_cast<double>(process_total) / \
+      (num_blocks * kBlockSize);
+  r.process_worst_ns = process_worst;
+  r.prepare_ns = static_cast<double>(prepare_total) / num_blocks;
+  r.prepare_worst_ns = prepare_worst;
+  r.block_worst_ns = block_worst;
+  return r;
+}
+
+// Keeps, for each figure, the best of several runs: the fastest run is the
+// one least disturbed by the rest of the system.
+void KeepBest(const Result& run, Result* best) {
+  best->process_ns_per_sample = min(
+      best->process_ns_per_sample, run.process_ns_per_sample);
+  best->process_worst_ns = min(best->process_worst_ns, run.process_worst_ns);
+  best->prepare_ns = min(best->prepare_ns, run.prepare_ns);
+  best->prepare_worst_ns = min(best->prepare_worst_ns, run.prepare_worst_ns);
+  best->block_worst_ns = min(best->block_worst_ns, run.block_worst_ns);
+}
+
+bool WriteBaseline(const char* file_name, const vector<Result>& results) {
+  FILE* fp = fopen(file_name, "w");
+  if (!fp) {
+    return false;
+  }
+  fprintf(fp, "config,process_ns_per_sample,process_worst_ns,"
+      "prepare_ns,prepare_worst_ns,block_worst_ns\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    fprintf(fp, "%s,%.2f,%.0f,%.0f,%.0f,%.0f\n",
+        r.name.c_str(),
+        r.process_ns_per_sample, r.process_worst_ns,
+        r.prepare_ns, r.prepare_worst_ns, r.block_worst_ns);
+  }
+  fclose(fp);
+  return true;
+}
+
+bool ReadBaseline(const char* file_name, vector<Result>* results) {
+  FILE* fp = fopen(file_name, "r");
+  if (!fp) {
+    return false;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), fp)) {
+    char name[64];
+    Result r;
+    if (sscanf(line, "%63[^,],%lf,%lf,%lf,%lf,%lf", name,
+            &r.process_ns_per_sample, &r.process_worst_ns,
+            &r.prepare_ns, &r.prepare_worst_ns, &r.block_worst_ns) == 6) {
+      r.name = name;
+      results->push_back(r);
+    }
+  }
+  fclose(fp);
+  return true;
+}
+
+// Only the averages are compared: worst-case timings on a host are too noisy
+// to fail a build on. They are still printed side by side.
+bool Compare(
+    const vector<Result>& baseline,
+    const vector<Result>& results,
+    double tolerance) {
+  bool success = true;
+  printf("\n%-24s %10s %10s %7s %10s %10s %7s\n", "config",
+      "ns/smp", "was", "delta", "prep ns", "was", "delta");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    const Result* b = NULL;
+    for (size_t j = 0; j < baseline.size(); ++j) {
+      if (baseline[j].name == r.name) {
+        b = &baseline[j];
+      }
+    }
+    if (!b) {
+      printf("%-24s (not in baseline)\n", r.name.c_str());
+      continue;
+    }
+    double process_delta = r.process_ns_per_sample / \
+        b->process_ns_per_sample - 1.0;
+    double prepare_delta = b->prepare_ns > 0.0
+        ? r.prepare_ns / b->prepare_ns - 1.0 : 0.0;
+    bool regression = process_delta > tolerance || prepare_delta > tolerance;
+    printf("%-24s %10.2f %10.2f %+6.1f%% %10.0f %10.0f %+6.1f%%%s\n",
+        r.name.c_str(),
+        r.process_ns_per_sample, b->process_ns_per_sample,
+        100.0 * process_delta,
+        r.prepare_ns, b->prepare_ns,
+        100.0 * prepare_delta,
+        regression ? "  REGRESSION" : "");
+    success = success && !regression;
+  }
+  return success;
+}
+
+void PrintLayout(const char* name, void (*report_layout)(FxLayoutReport*)) {
+  FxLayoutReport report;
+  report_layout(&report);
+  printf("%s: %d lines, %d of %d samples used, %d left\n", name,
+      report.num_lines, report.footprint, report.size, report.unused);
+  for (int32_t i = 0; i < report.num_lines; ++i) {
+    printf("  line %2d  base %6d  length %6d\n", i,
+        report.base[i], report.length[i]);
+  }
+}
+
+void Usage(const char* name) {
+  fprintf(stderr,
+      "Usage: %s [options]\n"
+      "  -m mode       only benchmark this playback mode\n"
+      "  -q quality    only benchmark this quality\n"
+      "  -d seconds    duration of audio processed per run (default 20)\n"
+      "  -r runs       number of runs, the best one is kept (default 3)\n"
+      "  -o file       write the results to a CSV baseline\n"
+      "  -c file       compare with a CSV baseline\n"
+      "  -t percent    tolerance of the comparison (default 10)\n"
+      "  -l            print the delay memory layout of the effects\n"
+#ifdef PROFILE_STAGES
+      "  -s            print the per-stage profile of each configuration\n"
+#endif  // PROFILE_STAGES
+      ,
+      name);
+}
+
+int main(int argc, char** argv) {
+  _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+
+  int mode_filter = -1;
+  int quality_filter = -1;
+  float duration = 20.0f;
+  int num_runs = 3;
+  const char* output_file = NULL;
+  const char* baseline_file = NULL;
+  double tolerance = 0.1;
+#ifdef PROFILE_STAGES
+  bool print_stages = false;
+#endif  // PROFILE_STAGES
+
+  int option;
+  while ((option = getopt(argc, argv, "m:q:d:r:o:c:t:lsh")) != -1) {
+    switch (option) {
+      case 'm':
+        {
+          PlaybackMode mode;
+          if (!Renderer::ParsePlaybackMode(optarg, &mode)) {
+            fprintf(stderr, "Unknown playback mode: %s\n", optarg);
+            return 1;
+          }
+          mode_filter = mode;
+        }
+        break;
+      case 'q':
+        quality_filter = atoi(optarg);
+        break;
+      case 'd':
+        duration = atof(optarg);
+        break;
+      case 'r':
+        num_runs = max(1, atoi(optarg));
+        break;
+      case 'o':
+        output_file = optarg;
+        break;
+      case 'c':
+        baseline_file = optarg;
+        break;
+      case 't':
+        tolerance = atof(optarg) / 100.0;
+        break;
+      case 'l':
+        PrintLayout("reverb", &Reverb::ReportLayout);
+        PrintLayout("diffuser", &Diffuser::ReportLayout);
+        PrintLayout("pitch_shifter", &PitchShifter::ReportLayout);
+        return 0;
+#ifdef PROFILE_STAGES
+      case 's':
+        print_stages = true;
+        break;
+#endif  // PROFILE_STAGES
+      default:
+        Usage(argv[0]);
+        return option == 'h' ? 0 : 1;
+    }
+  }
+
+  size_t num_blocks = static_cast<size_t>(duration * kSampleRate) / kBlockSize;
+  vector<ShortFrame> input(max(num_blocks, size_t(1)) * kBlockSize);
+  SynthesizeInput(&input[0], input.size(), 0);
+
+  Renderer renderer;
+  vector<Result> results;
+  printf("%-24s %10s %10s %10s %10s %10s %7s\n", "config",
+      "ns/smp", "worst ns", "prep ns", "prep worst", "blk worst", "budget");
+  for (int32_t mode = 0; mode < PLAYBACK_MODE_LAST; ++mode) {
+    if (mode_filter != -1 && mode != mode_filter) {
+      continue;
+    }
+    for (int32_t quality = 0; quality < 4; ++quality) {
+      if (quality_filter != -1 && quality != quality_filter) {
+        continue;
+      }
+      PlaybackMode playback_mode = static_cast<PlaybackMode>(mode);
+      Result best = Run(&renderer, playback_mode, quality, input);
+      for (int run = 1; run < num_runs; ++run) {
+        KeepBest(Run(&renderer, playback_mode, quality, input), &best);
+      }
+      printf("%-24s %10.2f %10.0f %10.0f %10.0f %10.0f %6.1f%%\n",
+          best.name.c_str(),
+          best.process_ns_per_sample, best.process_worst_ns,
+          best.prepare_ns, best.prepare_worst_ns, best.block_worst_ns,
+          100.0 * best.block_worst_ns / kBlockBudgetNs);
+#ifdef PROFILE_STAGES
+      if (print_stages) {
+        renderer.PrintProfile(stdout);
+        printf("\n");
+      }
+#endif  // PROFILE_STAGES
+      fflush(stdout);
+      results.push_back(best);
+    }
+  }
+
+  if (output_file && !WriteBaseline(output_file, results)) {
+    fprintf(stderr, "Cannot write %s\n", output_file);
+    return 1;
+  }
+  if (baseline_file) {
+    vector<Result> baseline;
+    if (!ReadBaseline(baseline_file, &baseline)) {
+      fprintf(stderr, "Cannot read %s\n", baseline_file);
+      return 1;
+    }
+    if (!Compare(baseline, results, tolerance)) {
+      return 2;
+    }
+  }
+  return 0;
+}
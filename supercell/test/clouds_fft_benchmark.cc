@@ -0,0 +1,351 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Microbenchmark of the FFT backends of the STFT.
+//
+// ShyFFT and RealFFT are run at the FFT sizes of the spectral modes on the
+// same windowed noise, and so is the paired transform of the stereo STFT
+// (one complex FFT or IFFT for two channels, see STFT::set_partner()). For
+// each size, the best time of a forward and of an inverse transform is
+// reported - for the paired transform, of both channels - followed by the
+// error of each one against a double precision DFT (largest difference,
+// relative to the largest magnitude).
+//
+// The ShyFFT figures are those of the stmlib checkout the tool is built
+// against, and only host timings are measured here.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+
+#include "stmlib/fft/shy_fft.h"
+
+#include "supercell/dsp/pvoc/real_fft.h"
+#include "supercell/dsp/pvoc/stft.h"
+
+using namespace clouds;
+using namespace std;
+
+typedef stmlib::ShyFFT<float, kMaxFftSize, stmlib::RotationPhasor> ShyFFT;
+
+inline uint64_t Now() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return static_cast<uint64_t>(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+struct Timing {
+  double direct_ns;
+  double inverse_ns;
+};
+
+// Both backends destroy the input of the inverse transform, so it is
+// restored before each call; the copy is timed separately and subtracted.
+template<typename T>
+Timing Run(
+    T* fft,
+    const float* input,
+    float* spectrum,
+    float* scratch,
+    float* output,
+    size_t num_passes,
+    int num_iterations) {
+  size_t size = static_cast<size_t>(1) << num_passes;
+  Timing t;
+
+  uint64_t start = Now();
+  for (int i = 0; i < num_iterations; ++i) {
+    fft->Direct(input, spectrum, num_passes);
+  }
+  t.direct_ns = static_cast<double>(Now() - start) / num_iterations;
+
+  start = Now();
+  for (int i = 0; i < num_iterations; ++i) {
+    copy(&spectrum[0], &spectrum[size], &scratch[0]);
+  }
+  uint64_t copy_time = Now() - start;
+
+  start = Now();
+  for (int i = 0; i < num_iterations; ++i) {
+    copy(&spectrum[0], &spectrum[size], &scratch[0]);
+    fft->Inverse(scratch, output, num_passes);
+  }
+  uint64_t inverse_time = Now() - start;
+  t.inverse_ns = static_cast<double>(
+      inverse_time - min(inverse_time, copy_time)) / num_iterations;
+  return t;
+}
+
+// The paired transform runs in place, on the two channels: the input is
+// restored before each call, and the copy subtracted, in both directions.
+// As in the STFT, the input of the forward transform is in bit-reversed
+// order, and so is the output of the inverse transform.
+Timing RunPaired(
+    const float* const* input,
+    float* const* spectrum,
+    float* const* scratch,
+    size_t num_passes,
+    int num_iterations) {
+  size_t size = static_cast<size_t>(1) << num_passes;
+  Timing t;
+
+  uint64_t start = Now();
+  for (int i = 0; i < num_iterations; ++i) {
+    copy(&input[0][0], &input[0][size], &scratch[0][0]);
+    copy(&input[1][0], &input[1][size], &scratch[1][0]);
+  }
+  uint64_t copy_time = Now() - start;
+
+  start = Now();
+  for (int i = 0; i < num_iterations; ++i) {
+    copy(&input[0][0], &input[0][size], &spectrum[0][0]);
+    copy(&input[1][0], &input[1][size], &spectrum[1][0]);
+    RealFFT::DirectComplex(spectrum[0], spectrum[1], num_passes);
+    RealFFT::SplitSpectra(spectrum[0], spectrum[1], size);
+  }
+  uint64_t direct_time = Now() - start;
+  t.direct_ns = static_cast<double>(
+      direct_time - min(direct_time, copy_time)) / num_iterations;
+
+  start = Now();
+  for (int i = 0; i < num_iterations; ++i) {
+    copy(&spectrum[0][0], &spectrum[0][size], &scratch[0][0]);
+    copy(&spectrum[1][0], &spectrum[1][size], &scratch[1][0]);
+    RealFFT::MergeSpectra(scratch[0], scratch[1], size);
+    RealFFT::InverseComplex(scratch[0], scratch[1], num_passes);
+  }
+  uint64_t inverse_time = Now() - start;
+  t.inverse_ns = static_cast<double>(
+      inverse_time - min(inverse_time, copy_time)) / num_iterations;
+  return t;
+}
+
+template<typename T>
+Timing Best(
+    T* fft,
+    const float* input,
+    float* spectrum,
+    float* scratch,
+    float* output,
+    size_t num_passes,
+    int num_iterations,
+    int num_runs) {
+  Timing best = Run(
+      fft, input, spectrum, scratch, output, num_passes, num_iterations);
+  for (int run = 1; run < num_runs; ++run) {
+    Timing t = Run(
+        fft, input, spectrum, scratch, output, num_passes, num_iterations);
+    best.direct_ns = min(best.direct_ns, t.direct_ns);
+    best.inverse_ns = min(best.inverse_ns, t.inverse_ns);
+  }
+  return best;
+}
+
+Timing BestPaired(
+    const float* const* input,
+    float* const* spectrum,
+    float* const* scratch,
+    size_t num_passes,
+    int num_iterations,
+    int num_runs) {
+  Timing best = RunPaired(input, spectrum, scratch, num_passes, num_iterations);
+  for (int run = 1; run < num_runs; ++run) {
+    Timing t = RunPaired(input, spectrum, scratch, num_passes, num_iterations);
+    best.direct_ns = min(best.direct_ns, t.direct_ns);
+    best.inverse_ns = min(best.inverse_ns, t.inverse_ns);
+  }
+  return best;
+}
+
+// Spectrum of x in the packed layout of the backends (re[0..n/2], then
+// im[1..n/2-1]), not normalized.
+void ReferenceDirect(const float* x, double* spectrum, size_t size) {
+  for (size_t k = 0; k <= size / 2; ++k) {
+    double re = 0.0;
+    double im = 0.0;
+    for (size_t i = 0; i < size; ++i) {
+      double phase = 2.0 * M_PI * static_cast<double>((k * i) % size) / size;
+      re += x[i] * cos(phase);
+      im -= x[i] * sin(phase);
+    }
+    spectrum[k] = re;
+    if (k != 0 && k != size / 2) {
+      spectrum[size / 2 + k] = im;
+    }
+  }
+}
+
+double RelativeError(const double* reference, const float* x, size_t size) {
+  double error = 0.0;
+  double peak = 0.0;
+  for (size_t i = 0; i < size; ++i) {
+    error = max(error, fabs(reference[i] - x[i]));
+    peak = max(peak, fabs(reference[i]));
+  }
+  return peak > 0.0 ? error / peak : error;
+}
+
+void Usage(const char* name) {
+  fprintf(stderr,
+      "Usage: %s [options]\n"
+      "  -n count      transforms per run (default 1000)\n"
+      "  -r runs       number of runs, the best one is kept (default 3)\n",
+      name);
+}
+
+int main(int argc, char** argv) {
+  int num_iterations = 1000;
+  int num_runs = 3;
+
+  int option;
+  while ((option = getopt(argc, argv, "n:r:h")) != -1) {
+    switch (option) {
+      case 'n':
+        num_iterations = max(1, atoi(optarg));
+        break;
+      case 'r':
+        num_runs = max(1, atoi(optarg));
+        break;
+      default:
+        Usage(argv[0]);
+        return option == 'h' ? 0 : 1;
+    }
+  }
+
+  static ShyFFT shy_fft;
+  static RealFFT real_fft;
+  shy_fft.Init();
+  real_fft.Init();
+
+  static float input[2][kMaxFftSize];
+  static float reversed_input[2][kMaxFftSize];
+  static float reference_float[kMaxFftSize];
+  static double reference_spectrum[2][kMaxFftSize];
+  static double reference_output[2][kMaxFftSize];
+  static float shy_spectrum[kMaxFftSize];
+  static float shy_output[kMaxFftSize];
+  static float real_spectrum[kMaxFftSize];
+  static float real_output[kMaxFftSize];
+  static float pair_spectrum[2][kMaxFftSize];
+  static float pair_output[2][kMaxFftSize];
+  static float pair_scratch[2][kMaxFftSize];
+  static float scratch[kMaxFftSize];
+  const float* pair_input[2] = { reversed_input[0], reversed_input[1] };
+  float* pair_spectrum_ptr[2] = { pair_spectrum[0], pair_spectrum[1] };
+  float* pair_scratch_ptr[2] = { pair_scratch[0], pair_scratch[1] };
+
+  Timing shy[3];
+  Timing real[3];
+  Timing pair[3];
+  double error[3][6];
+  size_t num_sizes = 0;
+  for (size_t num_passes = 10; (1U << num_passes) <= kMaxFftSize;
+       ++num_passes, ++num_sizes) {
+    size_t size = static_cast<size_t>(1) << num_passes;
+    srand(0x21);
+    for (int channel = 0; channel < 2; ++channel) {
+      for (size_t i = 0; i < size; ++i) {
+        float window = 0.5f - 0.5f * cosf(2.0f * M_PI * i / size);
+        input[channel][i] = window * 32767.0f * (
+            static_cast<float>(rand()) / RAND_MAX - 0.5f);
+        reversed_input[channel][RealFFT::BitReversedIndex(i, num_passes)] = \
+            input[channel][i];
+        // Neither inverse transform is normalized.
+        reference_output[channel][i] = static_cast<double>(size) * \
+            input[channel][i];
+      }
+      ReferenceDirect(input[channel], reference_spectrum[channel], size);
+    }
+
+    shy[num_sizes] = Best(
+        &shy_fft, input[0], shy_spectrum, scratch, shy_output,
+        num_passes, num_iterations, num_runs);
+    real[num_sizes] = Best(
+        &real_fft, input[0], real_spectrum, scratch, real_output,
+        num_passes, num_iterations, num_runs);
+    pair[num_sizes] = BestPaired(
+        pair_input, pair_spectrum_ptr, pair_scratch_ptr,
+        num_passes, num_iterations, num_runs);
+
+    // The inverse transforms are all run on the reference spectrum.
+    double* e = error[num_sizes];
+    copy(
+        &reference_spectrum[0][0], &reference_spectrum[0][size],
+        &reference_float[0]);
+    e[0] = RelativeError(reference_spectrum[0], shy_spectrum, size);
+    e[1] = RelativeError(reference_spectrum[0], real_spectrum, size);
+    e[2] = max(
+        RelativeError(reference_spectrum[0], pair_spectrum[0], size),
+        RelativeError(reference_spectrum[1], pair_spectrum[1], size));
+
+    copy(&reference_float[0], &reference_float[size], &scratch[0]);
+    shy_fft.Inverse(scratch, shy_output, num_passes);
+    copy(&reference_float[0], &reference_float[size], &scratch[0]);
+    real_fft.Inverse(scratch, real_output, num_passes);
+    for (int channel = 0; channel < 2; ++channel) {
+      copy(
+          &reference_spectrum[channel][0], &reference_spectrum[channel][size],
+          &pair_scratch[channel][0]);
+    }
+    RealFFT::MergeSpectra(pair_scratch[0], pair_scratch[1], size);
+    RealFFT::InverseComplex(pair_scratch[0], pair_scratch[1], num_passes);
+    for (int channel = 0; channel < 2; ++channel) {
+      for (size_t i = 0; i < size; ++i) {
+        pair_output[channel][i] = pair_scratch[channel][
+            RealFFT::BitReversedIndex(i, num_passes)];
+      }
+    }
+    e[3] = RelativeError(reference_output[0], shy_output, size);
+    e[4] = RelativeError(reference_output[0], real_output, size);
+    e[5] = max(
+        RelativeError(reference_output[0], pair_output[0], size),
+        RelativeError(reference_output[1], pair_output[1], size));
+  }
+
+  printf("%-6s %12s %12s %12s %12s %12s %12s\n", "size",
+      "shy fwd ns", "shy inv ns", "real fwd ns", "real inv ns",
+      "pair fwd ns", "pair inv ns");
+  for (size_t i = 0; i < num_sizes; ++i) {
+    printf("%-6d %12.0f %12.0f %12.0f %12.0f %12.0f %12.0f\n",
+        1 << (10 + i),
+        shy[i].direct_ns, shy[i].inverse_ns,
+        real[i].direct_ns, real[i].inverse_ns,
+        pair[i].direct_ns, pair[i].inverse_ns);
+  }
+  printf("\n%-6s %12s %12s %12s %12s %12s %12s\n", "size",
+      "shy fwd err", "shy inv err", "real fwd err", "real inv err",
+      "pair fwd err", "pair inv err");
+  for (size_t i = 0; i < num_sizes; ++i) {
+    printf("%-6d %12.2e %12.2e %12.2e %12.2e %12.2e %12.2e\n",
+        1 << (10 + i),
+        error[i][0], error[i][3], error[i][1], error[i][4],
+        error[i][2], error[i][5]);
+  }
+  return 0;
+}
@@ -0,0 +1,596 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// Golden-output regression harness.
+//
+// Renders a fixed corpus - the synthetic input and parameter sweeps of
+// corpus.h, with the default seed - through every playback mode at the four
+// quality settings, and through the variants listed in kVariants (processor
+// settings other than the defaults), and compares the output with reference
+// renders stored as 16-bit WAV files, one per configuration
+// (<mode>_q<quality>.wav, or the name of the variant):
+//
+//   clouds_golden -w supercell/test/golden    writes the references,
+//   clouds_golden -c supercell/test/golden    compares with them.
+//
+// For each configuration, the comparison reports whether the output is
+// bit-exact, the largest absolute difference in LSBs and the SNR of the
+// output against the reference. A configuration fails when its SNR is below
+// -s or its largest difference above -e; with -x, any difference fails.
+//
+// In compare mode, the spectral configurations also go through a save and load
+// round trip (<name>_save_load): after the load, the output must be within
+// rounding of that of the processor which saved, and within a fixed tolerance
+// of the output of a processor which never saved. The report is against the
+// latter.
+//
+// The references are rendered by the default host build, and make check
+// requires it to match them bit for bit: fixed-point and approximate kernels
+// have their own configurations. Builds which swap a kernel for an
+// approximate one, such as REAL_FFT=TRUE, are checked against the
+// tolerances instead. Changes that are meant to alter the sound rewrite the
+// references of the modes they affect.
+//
+// The output also depends on the stmlib checkout: ShyFFT, and the units and
+// approximations of stmlib/dsp. The references come with a fingerprint of
+// these (kFingerprintFile), and references rendered against another stmlib
+// are rejected before any configuration is compared.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <xmmintrin.h>
+
+#include "stmlib/dsp/dsp.h"
+#include "stmlib/dsp/units.h"
+#include "stmlib/fft/shy_fft.h"
+
+#include "supercell/test/corpus.h"
+#include "supercell/test/render_job.h"
+#include "supercell/test/renderer.h"
+#include "supercell/test/wav_file.h"
+
+using namespace clouds;
+using namespace std;
+
+const size_t kBlockSize = 32;
+
+// The corpus is short, to keep the references small: the parameter sweeps of
+// corpus.h are played faster so that they still go through most settings. It
+// is long enough for the spectral modes at the largest FFT size and overlap,
+// which start with 160 ms of latency, to render most of it.
+const float kDefaultDuration = 1.0f;
+const float kSweepSpeed = 8.0f;
+
+// Configurations rendered in addition to the playback mode and quality grid,
+// as settings of a RenderJob.
+struct Variant {
+  const char* name;
+  const char* settings;
+};
+
+const Variant kVariants[] = {
+  { "granular_q2_fixed_fx", "mode=granular quality=2 fixed_point_fx=1" },
+  { "looping_delay_q3_fixed_fx",
+    "mode=looping_delay quality=3 fixed_point_fx=1" },
+  { "spectral_q2_fixed_fx", "mode=spectral quality=2 fixed_point_fx=1" },
+  { "spectral_q0_fft1024", "mode=spectral quality=0 fft=1024" },
+  { "spectral_cloud_q0_fft2048", "mode=spectral_cloud quality=0 fft=2048" },
+  { "spectral_q1_overlap2", "mode=spectral quality=1 overlap=2" },
+  { "spectral_cloud_q1_overlap8",
+    "mode=spectral_cloud quality=1 overlap=8" },
+  { "spectral_q0_texture16", "mode=spectral quality=0 texture_bits=16" },
+  { "spectral_q1_texture8", "mode=spectral quality=1 texture_bits=8" },
+  { "spectral_q1_dry_delay", "mode=spectral quality=1 dry_delay=1" },
+  { "spectral_q0_paired_fft", "mode=spectral quality=0 paired_fft=1" },
+  { "spectral_cloud_q2_paired_fft",
+    "mode=spectral_cloud quality=2 paired_fft=1" },
+  { "looping_delay_q2_decimated_fx",
+    "mode=looping_delay quality=2 decimated_fx=1" },
+  { "spectral_q3_decimated_dry",
+    "mode=spectral quality=3 decimated_fx=1 dry_delay=1" },
+};
+
+struct Config {
+  string name;
+  RenderJob job;
+};
+
+// Length of the round trip test, saved halfway - a whole number of hops of
+// every FFT size and quality - and the number of frames after the load that
+// are not compared, for the STFT and sample rate converters of the fresh
+// processor to fill up.
+const size_t kRoundTripDuration = 65536;
+const size_t kRoundTripLatency = 16384;
+
+// The effects after the spectral engine - the pitch shifter of the spectral
+// cloud, mostly - keep state that is not saved, and settle to within rounding
+// of the processor that saved. Packing the spectral textures for a save also
+// rounds them, so both drift slightly from the processor that never saved.
+const int32_t kRoundTripMaxDrift = 2;
+const int32_t kRoundTripMaxError = 16;
+const double kRoundTripMinSnr = 50.0;
+
+const char kFingerprintFile[] = "stmlib.txt";
+
+struct Comparison {
+  bool exact;
+  int32_t max_error;
+  double snr;
+};
+
+typedef void (*Sweep)(float t, Parameters* parameters);
+
+// The sweeps of the corpus, at a fixed pitch. The pitch shifter of the
+// spectral cloud keeps a phase that drifts with the pitch and is not part of
+// a save.
+void SweepParametersAtUnison(float t, Parameters* parameters) {
+  SweepParameters(t, parameters);
+  parameters->pitch = 0.0f;
+}
+
+// Processes frames start to end of input, writing them to the same frames of
+// output. With a sweep, the parameters follow it; otherwise they are left as
+// they are.
+void Process(
+    Renderer* renderer,
+    const vector<ShortFrame>& input,
+    size_t start,
+    size_t end,
+    Sweep sweep,
+    vector<ShortFrame>* output) {
+  GranularProcessor* processor = renderer->processor();
+  Parameters* parameters = processor->mutable_parameters();
+  output->resize(input.size());
+  for (size_t i = start; i + kBlockSize <= end; i += kBlockSize) {
+    ShortFrame in[kBlockSize];
+    copy(&input[i], &input[i + kBlockSize], &in[0]);
+    if (sweep) {
+      float t = static_cast<float>(i) / kSampleRate;
+      sweep(t * kSweepSpeed, parameters);
+    }
+    processor->Process(in, &(*output)[i], kBlockSize);
+    processor->Prepare();
+  }
+}
+
+void Render(
+    Renderer* renderer,
+    const RenderJob& job,
+    const vector<ShortFrame>& input,
+    vector<ShortFrame>* output) {
+  renderer->Init(job.mode, job.quality, kBlockSize, job.seed);
+  ConfigureRenderer(job, renderer);
+  Process(renderer, input, 0, input.size(), SweepParameters, output);
+}
+
+// Saves the state of a processor, in the format written by ui.cc to a sample
+// memory.
+void Save(GranularProcessor* processor, vector<uint32_t>* data) {
+  PersistentBlock blocks[4];
+  size_t num_blocks;
+  processor->PreparePersistentData();
+  processor->GetPersistentData(blocks, &num_blocks);
+  data->clear();
+  for (size_t i = 0; i < num_blocks; ++i) {
+    const uint32_t* words = static_cast<const uint32_t*>(blocks[i].data);
+    data->push_back(blocks[i].tag);
+    data->push_back(blocks[i].size);
+    data->insert(data->end(), words, words + blocks[i].size / 4);
+  }
+  processor->ReleasePersistentData();
+}
+
+// FNV-1a.
+uint32_t Hash(uint32_t hash, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 16777619;
+  }
+  return hash;
+}
+
+// Hash of the output of the stmlib code used by the processor on fixed inputs:
+// the forward and inverse ShyFFT at the FFT sizes of the spectral modes, and
+// the conversions and soft clipping of stmlib/dsp.
+uint32_t StmlibFingerprint() {
+  typedef stmlib::ShyFFT<float, 4096, stmlib::RotationPhasor> ShyFFT;
+  static ShyFFT fft;
+  static float input[4096];
+  static float spectrum[4096];
+  static float output[4096];
+  fft.Init();
+
+  uint32_t hash = 2166136261U;
+  for (size_t num_passes = 10; num_passes <= 12; ++num_passes) {
+    size_t size = static_cast<size_t>(1) << num_passes;
+    uint32_t seed = 0x21;
+    for (size_t i = 0; i < size; ++i) {
+      seed = seed * 1664525L + 1013904223L;
+      input[i] = static_cast<float>(static_cast<int32_t>(seed) >> 16);
+    }
+    fft.Direct(input, spectrum, num_passes);
+    hash = Hash(hash, spectrum, size * sizeof(float));
+    fft.Inverse(spectrum, output, num_passes);
+    hash = Hash(hash, output, size * sizeof(float));
+  }
+
+  for (int32_t i = -512; i <= 512; ++i) {
+    float x = static_cast<float>(i) / 64.0f;
+    float y[2] = {
+      stmlib::SemitonesToRatio(x * 8.0f),
+      stmlib::SoftLimit(x)
+    };
+    hash = Hash(hash, y, sizeof(y));
+  }
+  return hash;
+}
+
+bool ReadFingerprint(const string& directory, uint32_t* fingerprint) {
+  string file_name = directory + "/" + kFingerprintFile;
+  FILE* fp = fopen(file_name.c_str(), "r");
+  if (!fp) {
+    return false;
+  }
+  bool success = fscanf(fp, "stmlib %x", fingerprint) == 1;
+  fclose(fp);
+  return success;
+}
+
+bool WriteFingerprint(const string& directory, uint32_t fingerprint) {
+  string file_name = directory + "/" + kFingerprintFile;
+  FILE* fp = fopen(file_name.c_str(), "w");
+  if (!fp) {
+    return false;
+  }
+  bool success = fprintf(fp, "stmlib %08x\n", fingerprint) > 0;
+  return fclose(fp) == 0 && success;
+}
+
+// The grid of playback modes and qualities, then the variants.
+bool ListConfigs(vector<Config>* configs) {
+  for (int32_t mode = 0; mode < PLAYBACK_MODE_LAST; ++mode) {
+    for (int32_t quality = 0; quality < 4; ++quality) {
+      Config config;
+      config.job.mode = static_cast<PlaybackMode>(mode);
+      config.job.quality = quality;
+      char name[64];
+      sprintf(name, "%s_q%d", Renderer::playback_mode_name(config.job.mode),
+          quality);
+      config.name = name;
+      configs->push_back(config);
+    }
+  }
+  for (size_t i = 0; i < sizeof(kVariants) / sizeof(kVariants[0]); ++i) {
+    Config config;
+    config.name = kVariants[i].name;
+    string settings = kVariants[i].settings;
+    size_t start = 0;
+    while (start < settings.size()) {
+      size_t end = settings.find(' ', start);
+      if (end == string::npos) {
+        end = settings.size();
+      }
+      string setting = settings.substr(start, end - start);
+      if (!config.job.Set(setting.c_str())) {
+        fprintf(stderr, "%s: invalid setting %s\n",
+            config.name.c_str(), setting.c_str());
+        return false;
+      }
+      start = end + 1;
+    }
+    configs->push_back(config);
+  }
+  return true;
+}
+
+bool ReadReference(const string& file_name, vector<ShortFrame>* frames) {
+  WavReader reader;
+  if (!reader.Open(file_name.c_str())) {
+    return false;
+  }
+  frames->resize(reader.num_frames());
+  return reader.Read(&(*frames)[0], frames->size()) == frames->size();
+}
+
+bool WriteReference(const string& file_name, const vector<ShortFrame>& frames) {
+  WavWriter writer;
+  if (!writer.Open(file_name.c_str(), static_cast<uint32_t>(kSampleRate))) {
+    return false;
+  }
+  bool success = writer.Write(&frames[0], frames.size());
+  writer.Close();
+  return success;
+}
+
+// Compares the frames of output from start on.
+Comparison Compare(
+    const vector<ShortFrame>& reference,
+    const vector<ShortFrame>& output,
+    size_t start) {
+  double signal = 0.0;
+  double noise = 0.0;
+  int32_t max_error = 0;
+  const short* r = &reference[0].l;
+  const short* o = &output[0].l;
+  for (size_t i = start * 2; i < output.size() * 2; ++i) {
+    int32_t error = abs(static_cast<int32_t>(o[i]) - r[i]);
+    signal += static_cast<double>(r[i]) * r[i];
+    noise += static_cast<double>(error) * error;
+    max_error = max(max_error, error);
+  }
+
+  Comparison c;
+  c.exact = max_error == 0;
+  c.max_error = max_error;
+  if (noise == 0.0) {
+    c.snr = HUGE_VAL;
+  } else if (signal == 0.0) {
+    c.snr = -HUGE_VAL;
+  } else {
+    c.snr = 10.0 * log10(signal / noise);
+  }
+  return c;
+}
+
+// Save and load round trip of the spectral modes. Two processors render the
+// first half of input with the parameter sweeps at unison, and one of them
+// saves its state, as ui.cc does. A third processor, set up afresh, loads the save.
+// All three then render the second half frozen, with neutral parameters.
+// Once the STFT of the fresh processor is past its latency, its output is
+// compared with that of the saving processor and of the one that never saved.
+bool RenderRoundTrip(
+    Renderer* renderers,
+    const RenderJob& job,
+    const vector<ShortFrame>& input,
+    Comparison* loaded_vs_saved,
+    Comparison* loaded_vs_unsaved) {
+  Renderer* saved = &renderers[1];
+  Renderer* loaded = &renderers[2];
+  vector<ShortFrame> output[3];
+  size_t half = input.size() / 2;
+  for (int32_t i = 0; i < 2; ++i) {
+    renderers[i].Init(job.mode, job.quality, kBlockSize, job.seed);
+    ConfigureRenderer(job, &renderers[i]);
+    Process(
+        &renderers[i], input, 0, half, SweepParametersAtUnison, &output[i]);
+  }
+
+  vector<uint32_t> data;
+  Save(saved->processor(), &data);
+  loaded->Init(job.mode, job.quality, kBlockSize, job.seed);
+  ConfigureRenderer(job, loaded);
+  if (!loaded->processor()->LoadPersistentData(&data[0])) {
+    return false;
+  }
+
+  for (int32_t i = 0; i < 3; ++i) {
+    GranularProcessor* processor = renderers[i].processor();
+    processor->Seed(job.seed);
+    Renderer::ResetParameters(processor->mutable_parameters());
+    processor->mutable_parameters()->freeze = true;
+    Process(&renderers[i], input, half, input.size(), NULL, &output[i]);
+  }
+  *loaded_vs_saved = Compare(output[1], output[2], half + kRoundTripLatency);
+  *loaded_vs_unsaved = Compare(output[0], output[2], half + kRoundTripLatency);
+  return true;
+}
+
+void Usage(const char* name) {
+  fprintf(stderr,
+      "Usage: %s [options] (-w directory | -c directory)\n"
+      "  -w directory  write the reference renders\n"
+      "  -c directory  compare with the reference renders\n"
+      "  -m mode       only this playback mode\n"
+      "  -q quality    only this quality\n"
+      "  -d seconds    duration of the corpus (default %.1f)\n"
+      "  -s dB         minimum SNR (default 55)\n"
+      "  -e lsb        maximum absolute difference (default 32)\n"
+      "  -x            require bit-exact output\n",
+      name, kDefaultDuration);
+}
+
+int main(int argc, char** argv) {
+  _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+
+  int mode_filter = -1;
+  int quality_filter = -1;
+  float duration = kDefaultDuration;
+  const char* write_directory = NULL;
+  const char* compare_directory = NULL;
+  double min_snr = 55.0;
+  int32_t max_error = 32;
+  bool exact = false;
+
+  int option;
+  while ((option = getopt(argc, argv, "w:c:m:q:d:s:e:xh")) != -1) {
+    switch (option) {
+      case 'w':
+        write_directory = optarg;
+        break;
+      case 'c':
+        compare_directory = optarg;
+        break;
+      case 'm':
+        {
+          PlaybackMode mode;
+          if (!Renderer::ParsePlaybackMode(optarg, &mode)) {
+            fprintf(stderr, "Unknown playback mode: %s\n", optarg);
+            return 1;
+          }
+          mode_filter = mode;
+        }
+        break;
+      case 'q':
+        quality_filter = atoi(optarg);
+        break;
+      case 'd':
+        duration = atof(optarg);
+        break;
+      case 's':
+        min_snr = atof(optarg);
+        break;
+      case 'e':
+        max_error = atoi(optarg);
+        break;
+      case 'x':
+        exact = true;
+        break;
+      default:
+        Usage(argv[0]);
+        return option == 'h' ? 0 : 1;
+    }
+  }
+  if (!write_directory == !compare_directory) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  size_t num_blocks = static_cast<size_t>(duration * kSampleRate) / kBlockSize;
+  vector<ShortFrame> input(max(num_blocks, size_t(1)) * kBlockSize);
+  SynthesizeInput(&input[0], input.size(), 0);
+
+  uint32_t fingerprint = StmlibFingerprint();
+  if (write_directory) {
+    if (!WriteFingerprint(write_directory, fingerprint)) {
+      fprintf(stderr, "Cannot write %s/%s\n", write_directory,
+          kFingerprintFile);
+      return 1;
+    }
+  } else {
+    uint32_t reference_fingerprint;
+    if (!ReadFingerprint(compare_directory, &reference_fingerprint)) {
+      fprintf(stderr, "Cannot read %s/%s\n", compare_directory,
+          kFingerprintFile);
+      return 1;
+    }
+    if (reference_fingerprint != fingerprint) {
+      fprintf(stderr,
+          "The references were rendered against another stmlib (fingerprint "
+          "%08x, this build %08x).\nRender them from a known good commit with "
+          "this stmlib (make golden), then compare the change with them.\n",
+          reference_fingerprint, fingerprint);
+      return 1;
+    }
+  }
+
+  Renderer renderer;
+  vector<ShortFrame> output;
+  vector<ShortFrame> reference;
+  int num_failures = 0;
+  if (compare_directory) {
+    printf("%-40s %6s %8s %10s\n", "config", "exact", "max err", "snr (dB)");
+  }
+  vector<Config> configs;
+  if (!ListConfigs(&configs)) {
+    return 1;
+  }
+  for (size_t i = 0; i < configs.size(); ++i) {
+    const RenderJob& job = configs[i].job;
+    const char* name = configs[i].name.c_str();
+    if ((mode_filter != -1 && job.mode != mode_filter) ||
+        (quality_filter != -1 && job.quality != quality_filter)) {
+      continue;
+    }
+    Render(&renderer, job, input, &output);
+
+    string file_name = string(write_directory
+        ? write_directory
+        : compare_directory) + "/" + name + ".wav";
+    if (write_directory) {
+      if (!WriteReference(file_name, output)) {
+        fprintf(stderr, "Cannot write %s\n", file_name.c_str());
+        return 1;
+      }
+      printf("%s\n", file_name.c_str());
+      continue;
+    }
+
+    if (!ReadReference(file_name, &reference)) {
+      printf("%-40s cannot read %s\n", name, file_name.c_str());
+      ++num_failures;
+      continue;
+    }
+    if (reference.size() != output.size()) {
+      printf("%-40s %u frames, reference has %u\n", name,
+          static_cast<unsigned>(output.size()),
+          static_cast<unsigned>(reference.size()));
+      ++num_failures;
+      continue;
+    }
+    Comparison c = Compare(reference, output, 0);
+    bool failed = exact
+        ? !c.exact
+        : c.snr < min_snr || c.max_error > max_error;
+    printf("%-40s %6s %8d %10.1f%s\n", name, c.exact ? "yes" : "no",
+        c.max_error, c.snr, failed ? "  FAILED" : "");
+    fflush(stdout);
+    num_failures += failed ? 1 : 0;
+  }
+
+  if (compare_directory) {
+    vector<ShortFrame> round_trip_input(kRoundTripDuration);
+    SynthesizeInput(&round_trip_input[0], round_trip_input.size(), 0);
+    Renderer round_trip_renderers[3];
+    for (size_t i = 0; i < configs.size(); ++i) {
+      const RenderJob& job = configs[i].job;
+      if ((job.mode != PLAYBACK_MODE_SPECTRAL &&
+           job.mode != PLAYBACK_MODE_SPECTRAL_CLOUD) ||
+          (mode_filter != -1 && job.mode != mode_filter) ||
+          (quality_filter != -1 && job.quality != quality_filter)) {
+        continue;
+      }
+      string name = configs[i].name + "_save_load";
+      Comparison saved;
+      Comparison unsaved;
+      if (!RenderRoundTrip(
+              round_trip_renderers, job, round_trip_input, &saved, &unsaved)) {
+        printf("%-40s cannot load the save\n", name.c_str());
+        ++num_failures;
+        continue;
+      }
+      bool failed = saved.max_error > kRoundTripMaxDrift ||
+          unsaved.snr < kRoundTripMinSnr ||
+          unsaved.max_error > kRoundTripMaxError;
+      printf("%-40s %6s %8d %10.1f%s\n", name.c_str(),
+          unsaved.exact ? "yes" : "no", unsaved.max_error, unsaved.snr,
+          failed ? "  FAILED" : "");
+      num_failures += failed ? 1 : 0;
+    }
+  }
+
+  if (num_failures) {
+    fprintf(stderr, "%d configuration(s) differ from the references\n",
+        num_failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,129 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Offline renderer: runs a WAV file through the firmware DSP.
+//
+// clouds_render [options] input.wav output.wav
+//
+// The processor runs at the module's sample rate (32kHz); input files at
+// another rate are processed as if they were at 32kHz. The output is always a
+// 16-bit stereo file.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <xmmintrin.h>
+
+#include "supercell/test/automation.h"
+#include "supercell/test/render_job.h"
+#include "supercell/test/renderer.h"
+
+using namespace clouds;
+using namespace std;
+
+void Usage(const char* name) {
+  fprintf(stderr,
+      "Usage: %s [options] input.wav output.wav\n"
+      "  -m mode         playback mode, by name or index (default: granular)\n"
+      "  -q quality      0: stereo 16-bit, 1: mono 16-bit,\n"
+      "                  2: stereo 8-bit lo-fi, 3: mono 8-bit lo-fi\n"
+      "  -f fft_size     FFT size of the spectral modes: 1024, 2048 or 4096\n"
+      "                  (default)\n"
+      "  -o overlap      overlap of the spectral modes: 2, 4 (default) or 8\n"
+      "  -x bits         bits per sample of the spectral textures: 32 (default,\n"
+      "                  float), 16 or 8 (logarithmic)\n"
+      "  -b block_size   samples per Process() call, even, <= %d (default)\n"
+      "  -a file         parameter automation file\n"
+      "  -p name=value   parameter value (can be repeated)\n"
+      "  -t seconds      tail of silence rendered after the input\n"
+      "  -c frames       frames read and written per chunk (default %d)\n"
+      "  -s seed         seed of the random generator (default 0x%x)\n"
+      "\n"
+      "Playback modes:\n",
+      name, static_cast<int>(kMaxBlockSize),
+      static_cast<int>(kDefaultChunkSize),
+      static_cast<unsigned int>(RandomGenerator::kDefaultSeed));
+  for (int32_t i = 0; i < PLAYBACK_MODE_LAST; ++i) {
+    fprintf(stderr, "  %d: %s\n", i,
+        Renderer::playback_mode_name(static_cast<PlaybackMode>(i)));
+  }
+  fprintf(stderr, "\nParameters:\n");
+  Automation::ListParameters(stderr);
+}
+
+int main(int argc, char** argv) {
+  _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+
+  RenderJob job;
+  int option;
+  while ((option = getopt(argc, argv, "m:q:f:o:x:b:a:p:t:c:s:h")) != -1) {
+    const char* key = NULL;
+    switch (option) {
+      case 'm': key = "mode"; break;
+      case 'q': key = "quality"; break;
+      case 'f': key = "fft"; break;
+      case 'o': key = "overlap"; break;
+      case 'x': key = "texture_bits"; break;
+      case 'b': key = "block"; break;
+      case 'a': key = "automation"; break;
+      case 't': key = "tail"; break;
+      case 'c': key = "chunk"; break;
+      case 's': key = "seed"; break;
+      case 'p':
+        if (!job.Set(optarg)) {
+          fprintf(stderr, "Invalid parameter setting: %s\n", optarg);
+          return 1;
+        }
+        break;
+      default:
+        Usage(argv[0]);
+        return option == 'h' ? 0 : 1;
+    }
+    if (key && !job.Set((string(key) + "=" + optarg).c_str())) {
+      fprintf(stderr, "Invalid value for -%c: %s\n", option, optarg);
+      return 1;
+    }
+  }
+  if (argc - optind != 2) {
+    Usage(argv[0]);
+    return 1;
+  }
+  job.input = argv[optind];
+  job.output = argv[optind + 1];
+
+  Renderer renderer;
+  string message;
+  bool success = RenderFile(job, &renderer, &message);
+  if (!message.empty()) {
+    fprintf(stderr, "%s%s\n", success ? "Warning: " : "Error: ",
+        message.c_str());
+  }
+#ifdef PROFILE_STAGES
+  renderer.PrintProfile(stderr);
+#endif  // PROFILE_STAGES
+  return success ? 0 : 1;
+}
@@ -0,0 +1,410 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Spectral analysis of the modifiers of the phase vocoder.
+//
+// clouds_spectrum [options] input.wav output.pvoc
+//
+// One channel of the input runs through an STFT and one of the modifiers, the
+// way the spectral modes process it, and the spectra going in and out of the
+// modifier are written at each hop (see spectrum_file.h for the format). As
+// with clouds_render, the input is processed as if it was at 32kHz.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <xmmintrin.h>
+
+#include "supercell/dsp/parameters.h"
+#include "supercell/dsp/pvoc/frame_transformation.h"
+#include "supercell/dsp/pvoc/spectral_clouds_transformation.h"
+#include "supercell/dsp/pvoc/stft.h"
+#include "supercell/dsp/random_generator.h"
+#include "supercell/resources.h"
+#include "supercell/test/automation.h"
+#include "supercell/test/renderer.h"
+#include "supercell/test/spectrum_file.h"
+#include "supercell/test/wav_file.h"
+
+using namespace clouds;
+using namespace std;
+
+// Stands between the STFT and the modifier under study, and writes the
+// spectra it receives and returns - of one hop out of decimation.
+class SpectrumTap : public Modifier {
+ public:
+  SpectrumTap(
+      Modifier* modifier,
+      SpectrumWriter* writer,
+      bool record_input,
+      bool record_output,
+      size_t decimation)
+      : modifier_(modifier),
+        writer_(writer),
+        record_input_(record_input),
+        record_output_(record_output),
+        decimation_(decimation),
+        hop_(0),
+        failed_(false) { }
+  ~SpectrumTap() { }
+
+  virtual uint32_t num_textures(size_t fft_size) const {
+    return modifier_->num_textures(fft_size);
+  }
+
+  virtual uint32_t texture_size(size_t fft_size) const {
+    return modifier_->texture_size(fft_size);
+  }
+
+  virtual void Init(float* buffer, int32_t fft_size, int32_t num_textures,
+                    float sample_rate_hz, FFT* fft, RandomGenerator* random) {
+    input_.resize(fft_size);
+    modifier_->Init(
+        buffer, fft_size, num_textures, sample_rate_hz, fft, random);
+  }
+
+  virtual void* snapshot(size_t* size) {
+    return modifier_->snapshot(size);
+  }
+
+  virtual void Process(
+      const Parameters& parameters,
+      float* fft_out,
+      float* ifft_in,
+      bool trigger) {
+    bool record = hop_++ % decimation_ == 0;
+    if (record && record_input_) {
+      // The modifier works in place.
+      copy(fft_out, fft_out + input_.size(), input_.begin());
+    }
+    modifier_->Process(parameters, fft_out, ifft_in, trigger);
+    if (record) {
+      const float* spectra[2];
+      size_t num_spectra = 0;
+      if (record_input_) {
+        spectra[num_spectra++] = &input_[0];
+      }
+      if (record_output_) {
+        spectra[num_spectra++] = ifft_in;
+      }
+      failed_ = !writer_->Write(spectra) || failed_;
+    }
+  }
+
+  inline bool failed() const { return failed_; }
+
+ private:
+  Modifier* modifier_;
+  SpectrumWriter* writer_;
+  bool record_input_;
+  bool record_output_;
+  size_t decimation_;
+  size_t hop_;
+  bool failed_;
+  vector<float> input_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpectrumTap);
+};
+
+enum Channel {
+  CHANNEL_LEFT,
+  CHANNEL_RIGHT,
+  CHANNEL_MIX
+};
+
+struct Settings {
+  Settings()
+      : cloud(false),
+        fft_size(kMaxFftSize),
+        hop_ratio(4),
+        texture_format(TEXTURE_FORMAT_FLOAT),
+        channel(CHANNEL_MIX),
+        record_input(true),
+        record_output(true),
+        decimation(1),
+        num_bins(0),
+        flags(SPECTRUM_FLAG_DB),
+        seed(RandomGenerator::kDefaultSeed) { }
+
+  bool cloud;
+  int32_t fft_size;
+  int32_t hop_ratio;
+  TextureFormat texture_format;
+  Channel channel;
+  bool record_input;
+  bool record_output;
+  size_t decimation;
+  size_t num_bins;  // 0 for all of them.
+  uint16_t flags;
+  uint32_t seed;
+  string automation;
+  vector<pair<string, float> > parameters;
+};
+
+inline double Now() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+inline bool ParseInteger(const char* s, long* value) {
+  char* end;
+  *value = strtol(s, &end, 10);
+  return *s && !*end;
+}
+
+bool Set(int option, const char* value, Settings* settings) {
+  long integer;
+  bool is_integer = ParseInteger(value, &integer);
+  switch (option) {
+    case 'm':
+      settings->cloud = !strcmp(value, "cloud");
+      return settings->cloud || !strcmp(value, "frame");
+    case 'f':
+      settings->fft_size = integer;
+      return is_integer && (
+          integer == 1024 || integer == 2048 || integer == 4096);
+    case 'o':
+      settings->hop_ratio = integer;
+      return is_integer && (integer == 2 || integer == 4 || integer == 8);
+    case 'x':
+      settings->texture_format = integer == 16 ? TEXTURE_FORMAT_16_BIT_LOG :
+          (integer == 8 ? TEXTURE_FORMAT_8_BIT_LOG : TEXTURE_FORMAT_FLOAT);
+      return is_integer && (integer == 32 || integer == 16 || integer == 8);
+    case 'c':
+      settings->channel = !strcmp(value, "left") ? CHANNEL_LEFT :
+          (!strcmp(value, "right") ? CHANNEL_RIGHT : CHANNEL_MIX);
+      return settings->channel != CHANNEL_MIX || !strcmp(value, "mix");
+    case 'k':
+      settings->record_input = strcmp(value, "out") != 0;
+      settings->record_output = strcmp(value, "in") != 0;
+      return !strcmp(value, "in") || !strcmp(value, "out") || \
+          !strcmp(value, "both");
+    case 'd':
+      settings->decimation = integer;
+      return is_integer && integer >= 1;
+    case 'n':
+      settings->num_bins = integer;
+      return is_integer && integer >= 1 && integer <= static_cast<long>(kMaxFftSize / 2);
+    case 'e':
+      settings->flags &= ~SPECTRUM_FLAG_DB;
+      settings->flags |= !strcmp(value, "db") ? SPECTRUM_FLAG_DB : 0;
+      return !strcmp(value, "db") || !strcmp(value, "float");
+    case 's':
+      settings->seed = strtoul(value, NULL, 0);
+      return true;
+    case 'a':
+      settings->automation = value;
+      return true;
+    case 'p':
+      {
+        const char* equal = strchr(value, '=');
+        if (!equal) {
+          return false;
+        }
+        string name(value, equal - value);
+        char* end;
+        float parameter_value = strtof(equal + 1, &end);
+        Parameters dummy;
+        if (!equal[1] || *end || \
+            !Automation::Set(name.c_str(), parameter_value, &dummy)) {
+          return false;
+        }
+        settings->parameters.push_back(make_pair(name, parameter_value));
+      }
+      return true;
+  }
+  return false;
+}
+
+void Usage(const char* name) {
+  fprintf(stderr,
+      "Usage: %s [options] input.wav output.pvoc\n"
+      "  -m modifier     frame (default, spectral mode) or cloud (spectral\n"
+      "                  cloud mode)\n"
+      "  -f fft_size     1024, 2048 or 4096 (default)\n"
+      "  -o overlap      2, 4 (default) or 8\n"
+      "  -x bits         bits per sample of the textures of the frame\n"
+      "                  modifier: 32 (default, float), 16 or 8 (logarithmic)\n"
+      "  -c channel      left, right or mix (default)\n"
+      "  -k spectra      in, out or both (default): the spectra received and\n"
+      "                  returned by the modifier\n"
+      "  -d decimation   records one hop out of decimation (default 1)\n"
+      "  -n bins         records the lowest bins only (default fft_size / 2)\n"
+      "  -e encoding     of the magnitudes: db (default, 16-bit) or float\n"
+      "  -P              records the phases\n"
+      "  -a file         parameter automation file\n"
+      "  -p name=value   parameter value (can be repeated)\n"
+      "  -s seed         seed of the random generator (default 0x%x)\n"
+      "\n"
+      "Parameters:\n",
+      name, static_cast<unsigned int>(RandomGenerator::kDefaultSeed));
+  Automation::ListParameters(stderr);
+}
+
+int main(int argc, char** argv) {
+  _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+
+  Settings settings;
+  int option;
+  while ((option = getopt(argc, argv, "m:f:o:x:c:k:d:n:e:Pa:p:s:h")) != -1) {
+    if (option == 'P') {
+      settings.flags |= SPECTRUM_FLAG_PHASES;
+    } else if (option == 'h' || option == '?') {
+      Usage(argv[0]);
+      return option == 'h' ? 0 : 1;
+    } else if (!Set(option, optarg, &settings)) {
+      fprintf(stderr, "Invalid value for -%c: %s\n", option, optarg);
+      return 1;
+    }
+  }
+  if (argc - optind != 2) {
+    Usage(argv[0]);
+    return 1;
+  }
+  const char* input_name = argv[optind];
+  const char* output_name = argv[optind + 1];
+  size_t fft_size = settings.fft_size;
+  size_t hop_size = fft_size / settings.hop_ratio;
+  size_t num_bins = settings.num_bins ? settings.num_bins : fft_size >> 1;
+  if (num_bins > fft_size >> 1) {
+    fprintf(stderr, "Error: more bins than fft_size / 2\n");
+    return 1;
+  }
+
+  Automation automation;
+  if (!settings.automation.empty() && \
+      !automation.Load(settings.automation.c_str())) {
+    fprintf(stderr, "Error: %s: %s\n", settings.automation.c_str(),
+        automation.error().c_str());
+    return 1;
+  }
+  WavReader reader;
+  if (!reader.Open(input_name)) {
+    fprintf(stderr, "Error: cannot read %s\n", input_name);
+    return 1;
+  }
+
+  SpectrumFileHeader header;
+  header.flags = settings.flags;
+  header.sample_rate = kSampleRate;
+  header.fft_size = fft_size;
+  header.hop_size = hop_size * settings.decimation;
+  header.num_bins = num_bins;
+  header.num_spectra = settings.record_input + settings.record_output;
+  SpectrumWriter writer;
+  if (!writer.Open(output_name, header)) {
+    fprintf(stderr, "Error: cannot write %s\n", output_name);
+    return 1;
+  }
+
+  FrameTransformation frame_transformation;
+  SpectralCloudsTransformation spectral_clouds_transformation;
+  frame_transformation.set_texture_format(settings.texture_format);
+  Modifier* modifier = &frame_transformation;
+  if (settings.cloud) {
+    modifier = &spectral_clouds_transformation;
+  }
+  SpectrumTap tap(
+      modifier,
+      &writer,
+      settings.record_input,
+      settings.record_output,
+      settings.decimation);
+
+  FFT fft;
+  RandomGenerator random;
+  random.Seed(settings.seed);
+  vector<float> fft_buffer(fft_size);
+  vector<float> ifft_buffer(fft_size);
+  vector<short> analysis_synthesis_buffer((fft_size + hop_size) * 2);
+  STFT stft;
+  stft.Init(
+      &fft,
+      fft_size,
+      hop_size,
+      &fft_buffer[0],
+      &ifft_buffer[0],
+      lut_sine_window_4096,
+      &analysis_synthesis_buffer[0],
+      &tap);
+  size_t num_textures = tap.num_textures(fft_size);
+  vector<float> textures(num_textures * tap.texture_size(fft_size));
+  tap.Init(
+      &textures[0], fft_size, num_textures, kSampleRate, &fft, &random);
+
+  Parameters parameters;
+  Renderer::ResetParameters(&parameters);
+  for (size_t i = 0; i < settings.parameters.size(); ++i) {
+    Automation::Set(
+        settings.parameters[i].first.c_str(),
+        settings.parameters[i].second,
+        &parameters);
+  }
+
+  // The modifier runs once per hop: the parameters are updated at the same
+  // rate.
+  vector<ShortFrame> frames(hop_size);
+  vector<float> input(hop_size);
+  vector<float> output(hop_size);
+  size_t num_frames = 0;
+  double start = Now();
+  while (size_t size = reader.Read(&frames[0], hop_size)) {
+    if (!automation.empty()) {
+      automation.Apply(num_frames / kSampleRate, &parameters);
+    }
+    if (!settings.cloud) {
+      FrameTransformation::MapParameters(&parameters);
+    }
+    for (size_t i = 0; i < size; ++i) {
+      int32_t sample = settings.channel == CHANNEL_LEFT ? frames[i].l :
+          (settings.channel == CHANNEL_RIGHT ? frames[i].r :
+          (frames[i].l + frames[i].r) >> 1);
+      input[i] = static_cast<float>(sample) / 32768.0f;
+    }
+    stft.Process(parameters, &input[0], &output[0], size, 1);
+    stft.Buffer();
+    num_frames += size;
+  }
+  double elapsed = Now() - start;
+  writer.Close();
+
+  if (tap.failed()) {
+    fprintf(stderr, "Error: cannot write %s\n", output_name);
+    return 1;
+  }
+  double duration = num_frames / kSampleRate;
+  fprintf(stderr, "%u frames of %u bins, %.1fs of audio in %.2fs (%.0fx)\n",
+      static_cast<unsigned int>(writer.header().num_frames),
+      static_cast<unsigned int>(num_bins),
+      duration, elapsed, elapsed > 0.0 ? duration / elapsed : 0.0);
+  return 0;
+}
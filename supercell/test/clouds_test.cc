@@ -32,6 +32,8 @@
 #include <vector>
 #include <xmmintrin.h>
 
+#include "stmlib/utils/random.h"
+
 #include "supercell/dsp/granular_processor.h"
 #include "supercell/resources.h"
 
@@ -107,7 +109,7 @@ void TestDSP() {
     // float triangle = tri / 32768.0f;
     
     p->gate = false;
-    p->trigger = false;// || (block_counter & 2047) > 1024;
+    p->capture = false;// || (block_counter & 2047) > 1024;
     p->freeze = false; // || (block_counter & 2047) > 1024;
     p->granular.reverse = true;
     pot_noise += 0.05f * ((Random::GetSample() / 32768.0f) * 0.05f - pot_noise);
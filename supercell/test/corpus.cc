@@ -0,0 +1,84 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// Synthetic input and parameter sweeps shared by the host tools.
+
+#include "supercell/test/corpus.h"
+
+#include <cmath>
+
+#include "supercell/test/renderer.h"
+
+namespace clouds {
+
+namespace {
+
+inline float Triangle(float phase) {
+  phase -= floorf(phase);
+  return phase < 0.5f ? 2.0f * phase : 2.0f - 2.0f * phase;
+}
+
+}  // namespace
+
+void SweepParameters(float t, Parameters* p) {
+  p->position = Triangle(t * 0.13f);
+  p->size = Triangle(t * 0.07f + 0.3f);
+  p->pitch = 24.0f * Triangle(t * 0.05f) - 12.0f;
+  p->density = Triangle(t * 0.11f + 0.1f);
+  p->texture = Triangle(t * 0.09f + 0.6f);
+  p->dry_wet = 0.5f + 0.5f * Triangle(t * 0.03f);
+  p->stereo_spread = Triangle(t * 0.17f);
+  p->feedback = 0.5f * Triangle(t * 0.04f);
+  p->reverb = 0.6f * Triangle(t * 0.06f + 0.5f);
+  p->freeze = Triangle(t * 0.125f) > 0.8f;
+  p->gate = Triangle(t * 2.0f) > 0.9f;
+  p->capture = Triangle(t * 0.5f) > 0.98f;
+  p->granular.reverse = Triangle(t * 0.02f) > 0.5f;
+  p->kammerl.probability = p->dry_wet;
+  p->kammerl.clock_divider = p->stereo_spread;
+  p->kammerl.pitch_mode = p->feedback;
+  p->kammerl.distortion = p->reverb;
+  p->kammerl.slice_selection = p->position;
+  p->kammerl.slice_modulation = p->texture;
+  p->kammerl.size_modulation = p->density;
+  p->kammerl.pitch = Triangle(t * 0.05f);
+}
+
+void SynthesizeInput(ShortFrame* frames, size_t size, size_t start) {
+  uint32_t seed = 0x1234567 + start;
+  for (size_t i = 0; i < size; ++i) {
+    float t = static_cast<float>(start + i) / kSampleRate;
+    seed = seed * 1664525L + 1013904223L;
+    float noise = static_cast<float>(static_cast<int32_t>(seed) >> 16);
+    float s = sinf(2.0f * M_PI * 220.0f * t) * (0.5f + 0.5f * Triangle(t));
+    frames[i].l = static_cast<short>(12000.0f * s + 0.05f * noise);
+    frames[i].r = static_cast<short>(9000.0f * sinf(2.0f * M_PI * 331.0f * t)
+        + 0.05f * noise);
+  }
+}
+
+}  // namespace clouds
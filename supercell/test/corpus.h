@@ -0,0 +1,51 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// Synthetic input and parameter sweeps shared by the host tools that need a
+// fixed, reproducible workload (benchmark and golden-output harness).
+
+#ifndef CLOUDS_TEST_CORPUS_H_
+#define CLOUDS_TEST_CORPUS_H_
+
+#include "stmlib/stmlib.h"
+
+#include "supercell/dsp/frame.h"
+#include "supercell/dsp/parameters.h"
+
+namespace clouds {
+
+// Slow, incommensurate sweeps of all the knobs and a few gate/freeze events,
+// so that all the code paths of a mode get exercised. t is in seconds.
+void SweepParameters(float t, Parameters* parameters);
+
+// Two sines with a slow amplitude modulation, and a little noise. start is the
+// index of the first frame, so that the signal can be generated in chunks.
+void SynthesizeInput(ShortFrame* frames, size_t size, size_t start);
+
+}  // namespace clouds
+
+#endif  // CLOUDS_TEST_CORPUS_H_
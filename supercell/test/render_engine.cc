@@ -0,0 +1,173 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Renders many jobs in parallel.
+
+#include "supercell/test/render_engine.h"
+
+#include <sys/stat.h>
+#include <xmmintrin.h>
+
+#include <algorithm>
+#include <ctime>
+
+#include "supercell/test/renderer.h"
+
+namespace clouds {
+
+using namespace std;
+
+namespace {
+
+double Now() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+// The input size is a good estimate of the cost of a job.
+struct LongestJobFirst {
+  explicit LongestJobFirst(const vector<off_t>& sizes) : sizes_(sizes) { }
+  bool operator()(size_t a, size_t b) const {
+    return sizes_[a] > sizes_[b] || (sizes_[a] == sizes_[b] && a < b);
+  }
+  const vector<off_t>& sizes_;
+};
+
+}  // namespace
+
+RenderEngine::~RenderEngine() {
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    pthread_mutex_destroy(&workers_[i]->lock);
+    delete workers_[i]->renderer;
+    delete workers_[i];
+  }
+}
+
+void RenderEngine::Init(size_t num_workers) {
+  num_workers_ = max(num_workers, size_t(1));
+  for (size_t i = 0; i < num_workers_; ++i) {
+    Worker* w = new Worker;
+    w->engine = this;
+    w->index = i;
+    w->renderer = new Renderer;
+    pthread_mutex_init(&w->lock, NULL);
+    workers_.push_back(w);
+  }
+}
+
+bool RenderEngine::NextJob(Worker* worker, size_t* job) {
+  // Own queue first, from the front...
+  pthread_mutex_lock(&worker->lock);
+  if (!worker->jobs.empty()) {
+    *job = worker->jobs.front();
+    worker->jobs.pop_front();
+    pthread_mutex_unlock(&worker->lock);
+    return true;
+  }
+  pthread_mutex_unlock(&worker->lock);
+
+  // ...then steal from the back of the others.
+  for (size_t i = 1; i < num_workers_; ++i) {
+    Worker* victim = workers_[(worker->index + i) % num_workers_];
+    pthread_mutex_lock(&victim->lock);
+    if (!victim->jobs.empty()) {
+      *job = victim->jobs.back();
+      victim->jobs.pop_back();
+      pthread_mutex_unlock(&victim->lock);
+      return true;
+    }
+    pthread_mutex_unlock(&victim->lock);
+  }
+  return false;
+}
+
+/* static */
+void* RenderEngine::WorkerMain(void* arg) {
+  Worker* worker = static_cast<Worker*>(arg);
+  RenderEngine* engine = worker->engine;
+  // The flush-to-zero mode is per thread.
+  _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+
+  size_t index;
+  while (engine->NextJob(worker, &index)) {
+    const RenderJob& job = (*engine->jobs_)[index];
+    RenderResult result;
+    double start = Now();
+    result.success = RenderFile(job, worker->renderer, &result.message);
+    result.seconds = Now() - start;
+    result.worker = worker->index;
+
+    pthread_mutex_lock(&engine->callback_lock_);
+    (*engine->results_)[index] = result;
+    if (!result.success) {
+      ++engine->num_failures_;
+    }
+    if (engine->callback_) {
+      engine->callback_(index, job, result, engine->callback_context_);
+    }
+    pthread_mutex_unlock(&engine->callback_lock_);
+  }
+  return NULL;
+}
+
+size_t RenderEngine::Render(
+    const vector<RenderJob>& jobs,
+    vector<RenderResult>* results,
+    RenderCallback callback,
+    void* callback_context) {
+  jobs_ = &jobs;
+  results_ = results;
+  callback_ = callback;
+  callback_context_ = callback_context;
+  num_failures_ = 0;
+  results->resize(jobs.size());
+
+  // Deal the jobs, longest first, round-robin to the workers.
+  vector<off_t> sizes(jobs.size());
+  vector<size_t> order(jobs.size());
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    struct stat s;
+    sizes[i] = stat(jobs[i].input.c_str(), &s) ? 0 : s.st_size;
+    order[i] = i;
+  }
+  sort(order.begin(), order.end(), LongestJobFirst(sizes));
+  for (size_t i = 0; i < order.size(); ++i) {
+    workers_[i % num_workers_]->jobs.push_back(order[i]);
+  }
+
+  pthread_mutex_init(&callback_lock_, NULL);
+  for (size_t i = 0; i < num_workers_; ++i) {
+    pthread_create(&workers_[i]->thread, NULL, &WorkerMain, workers_[i]);
+  }
+  for (size_t i = 0; i < num_workers_; ++i) {
+    pthread_join(workers_[i]->thread, NULL);
+  }
+  pthread_mutex_destroy(&callback_lock_);
+  return num_failures_;
+}
+
+}  // namespace clouds
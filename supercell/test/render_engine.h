@@ -0,0 +1,106 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Renders many jobs in parallel, each thread owning its own processor and
+// buffers. Jobs are dealt to per-thread queues and idle threads steal work
+// from the others, so that a few long files do not leave cores idle.
+
+#ifndef CLOUDS_TEST_RENDER_ENGINE_H_
+#define CLOUDS_TEST_RENDER_ENGINE_H_
+
+#include <pthread.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "stmlib/stmlib.h"
+
+#include "supercell/test/render_job.h"
+
+namespace clouds {
+
+class Renderer;
+
+struct RenderResult {
+  bool success;
+  std::string message;
+  double seconds;  // Wall-clock time spent on the job.
+  size_t worker;
+};
+
+// Called, serialized, each time a job is finished.
+typedef void (*RenderCallback)(
+    size_t index,
+    const RenderJob& job,
+    const RenderResult& result,
+    void* context);
+
+class RenderEngine {
+ public:
+  RenderEngine() : num_workers_(0) { }
+  ~RenderEngine();
+
+  void Init(size_t num_workers);
+
+  // Renders all the jobs, returns the number of jobs which failed.
+  size_t Render(
+      const std::vector<RenderJob>& jobs,
+      std::vector<RenderResult>* results,
+      RenderCallback callback,
+      void* callback_context);
+
+  inline size_t num_workers() const { return num_workers_; }
+
+ private:
+  struct Worker {
+    RenderEngine* engine;
+    size_t index;
+    Renderer* renderer;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    std::deque<size_t> jobs;
+  };
+
+  static void* WorkerMain(void* worker);
+  bool NextJob(Worker* worker, size_t* job);
+
+  size_t num_workers_;
+  std::vector<Worker*> workers_;
+
+  const std::vector<RenderJob>* jobs_;
+  std::vector<RenderResult>* results_;
+  RenderCallback callback_;
+  void* callback_context_;
+  size_t num_failures_;
+  pthread_mutex_t callback_lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(RenderEngine);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_TEST_RENDER_ENGINE_H_
@@ -0,0 +1,220 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Description and rendering of a WAV file through the processor, shared by
+// the host tools.
+
+#include "supercell/test/render_job.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "supercell/test/automation.h"
+#include "supercell/test/renderer.h"
+#include "supercell/test/wav_file.h"
+
+namespace clouds {
+
+using namespace std;
+
+RenderJob::RenderJob()
+    : mode(PLAYBACK_MODE_GRANULAR),
+      quality(0),
+      fft_size(kMaxFftSize),
+      hop_ratio(4),
+      texture_format(TEXTURE_FORMAT_FLOAT),
+      dry_delay(false),
+      paired_fft(false),
+      decimated_fx(false),
+      fixed_point_fx(false),
+      block_size(kMaxBlockSize),
+      chunk_size(kDefaultChunkSize),
+      tail(0.0f),
+      seed(RandomGenerator::kDefaultSeed) { }
+
+bool RenderJob::Set(const char* key_value) {
+  const char* separator = strchr(key_value, '=');
+  if (!separator || separator == key_value || !separator[1]) {
+    return false;
+  }
+  string key(key_value, separator - key_value);
+  const char* value = separator + 1;
+  char* end;
+  long integer = strtol(value, &end, 10);
+  bool is_integer = !*end;
+
+  if (key == "mode") {
+    return Renderer::ParsePlaybackMode(value, &mode);
+  } else if (key == "quality") {
+    quality = integer;
+    return is_integer && integer >= 0 && integer <= 3;
+  } else if (key == "fft") {
+    fft_size = integer;
+    return is_integer && (integer == 1024 || integer == 2048 || \
+        integer == 4096);
+  } else if (key == "overlap") {
+    hop_ratio = integer;
+    return is_integer && (integer == 2 || integer == 4 || integer == 8);
+  } else if (key == "texture_bits") {
+    texture_format = integer == 16 ? TEXTURE_FORMAT_16_BIT_LOG : \
+        (integer == 8 ? TEXTURE_FORMAT_8_BIT_LOG : TEXTURE_FORMAT_FLOAT);
+    return is_integer && (integer == 32 || integer == 16 || integer == 8);
+  } else if (key == "dry_delay") {
+    dry_delay = integer != 0;
+    return is_integer && (integer == 0 || integer == 1);
+  } else if (key == "paired_fft") {
+    paired_fft = integer != 0;
+    return is_integer && (integer == 0 || integer == 1);
+  } else if (key == "decimated_fx") {
+    decimated_fx = integer != 0;
+    return is_integer && (integer == 0 || integer == 1);
+  } else if (key == "fixed_point_fx") {
+    fixed_point_fx = integer != 0;
+    return is_integer && (integer == 0 || integer == 1);
+  } else if (key == "block") {
+    block_size = integer;
+    return is_integer && integer >= 2 && \
+        integer <= static_cast<long>(kMaxBlockSize) && !(integer & 1);
+  } else if (key == "chunk") {
+    chunk_size = integer;
+    return is_integer && integer > 0;
+  } else if (key == "tail") {
+    tail = strtof(value, &end);
+    return !*end && tail >= 0.0f;
+  } else if (key == "seed") {
+    seed = strtoul(value, &end, 0);
+    return !*end;
+  } else if (key == "automation") {
+    automation = value;
+    return true;
+  }
+  float parameter_value = strtof(value, &end);
+  Parameters dummy;
+  if (*end || !Automation::Set(key.c_str(), parameter_value, &dummy)) {
+    return false;
+  }
+  parameters.push_back(make_pair(key, parameter_value));
+  return true;
+}
+
+void ConfigureRenderer(const RenderJob& job, Renderer* renderer) {
+  GranularProcessor* processor = renderer->processor();
+  if (job.fft_size != processor->spectral_fft_size() ||
+      job.hop_ratio != processor->spectral_hop_ratio()) {
+    processor->set_spectral_fft_size(job.fft_size);
+    processor->set_spectral_hop_ratio(job.hop_ratio);
+    processor->Prepare();
+  }
+  if (job.texture_format != processor->spectral_texture_format() ||
+      job.dry_delay != processor->dry_delay() ||
+      job.paired_fft != processor->paired_transforms() ||
+      job.decimated_fx != processor->decimated_post_processing()) {
+    processor->set_spectral_texture_format(job.texture_format);
+    processor->set_dry_delay(job.dry_delay);
+    processor->set_paired_transforms(job.paired_fft);
+    processor->set_decimated_post_processing(job.decimated_fx);
+    processor->Prepare();
+  }
+  processor->set_fixed_point_post_processing(job.fixed_point_fx);
+  for (size_t i = 0; i < job.parameters.size(); ++i) {
+    Automation::Set(
+        job.parameters[i].first.c_str(),
+        job.parameters[i].second,
+        renderer->mutable_parameters());
+  }
+}
+
+bool RenderFile(const RenderJob& job, Renderer* renderer, string* message) {
+  message->clear();
+
+  Automation automation;
+  if (!job.automation.empty() && !automation.Load(job.automation.c_str())) {
+    *message = job.automation + ": " + automation.error();
+    return false;
+  }
+
+  WavReader reader;
+  if (!reader.Open(job.input.c_str())) {
+    *message = "cannot read " + job.input + \
+        " (8/16/24/32-bit PCM or float WAV)";
+    return false;
+  }
+  if (reader.sample_rate() != kSampleRate) {
+    char warning[128];
+    sprintf(warning, " is at %d Hz, processed as %d Hz",
+        reader.sample_rate(), static_cast<int>(kSampleRate));
+    *message = job.input + warning;
+  }
+  WavWriter writer;
+  if (!writer.Open(job.output.c_str(), kSampleRate)) {
+    *message = "cannot write " + job.output;
+    return false;
+  }
+
+  renderer->set_automation(NULL);
+  renderer->Init(job.mode, job.quality, job.block_size, job.seed);
+  ConfigureRenderer(job, renderer);
+  if (!automation.empty()) {
+    renderer->set_automation(&automation);
+  }
+
+  // Whole chunks are read, processed and written at once.
+  size_t chunk_size = job.chunk_size - job.chunk_size % job.block_size;
+  if (chunk_size < job.block_size) {
+    chunk_size = job.block_size;
+  }
+  vector<ShortFrame> input(chunk_size);
+  vector<ShortFrame> output(chunk_size);
+  size_t remaining_tail = static_cast<size_t>(job.tail * kSampleRate);
+  bool success = true;
+  while (true) {
+    size_t size = reader.Read(&input[0], chunk_size);
+    if (size < chunk_size && remaining_tail) {
+      size_t silence = chunk_size - size;
+      if (silence > remaining_tail) {
+        silence = remaining_tail;
+      }
+      memset(&input[size], 0, silence * sizeof(ShortFrame));
+      size += silence;
+      remaining_tail -= silence;
+    }
+    if (!size) {
+      break;
+    }
+    renderer->Render(&input[0], &output[0], size);
+    if (!writer.Write(&output[0], size)) {
+      *message = "error while writing " + job.output;
+      success = false;
+      break;
+    }
+  }
+  renderer->set_automation(NULL);
+  writer.Close();
+  return success;
+}
+
+}  // namespace clouds
@@ -0,0 +1,87 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Description and rendering of a WAV file through the processor, shared by
+// the host tools.
+
+#ifndef CLOUDS_TEST_RENDER_JOB_H_
+#define CLOUDS_TEST_RENDER_JOB_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "stmlib/stmlib.h"
+
+#include "supercell/dsp/granular_processor.h"
+
+namespace clouds {
+
+class Renderer;
+
+const size_t kDefaultChunkSize = 32768;
+
+struct RenderJob {
+  RenderJob();
+
+  // Sets one of the settings of the job from a "key=value" string. The keys
+  // are mode, quality, fft, overlap, texture_bits, dry_delay, paired_fft,
+  // decimated_fx, fixed_point_fx, block, chunk, tail, seed, automation, and
+  // the parameter names accepted in automation files. Returns false if the key is unknown or the value invalid.
+  bool Set(const char* key_value);
+
+  std::string input;
+  std::string output;
+  std::string automation;  // Empty if not automated.
+  PlaybackMode mode;
+  int32_t quality;
+  int32_t fft_size;  // Of the spectral modes.
+  int32_t hop_ratio;
+  TextureFormat texture_format;  // Of the spectral mode.
+  bool dry_delay;  // Of the spectral modes, see GranularProcessor.
+  bool paired_fft;  // One complex transform for both channels, in stereo.
+  bool decimated_fx;  // Post-processing at the decimated rate, low fidelity.
+  bool fixed_point_fx;  // Fixed-point diffuser and reverb, low fidelity.
+  size_t block_size;
+  size_t chunk_size;
+  float tail;  // Seconds of silence rendered after the input.
+  uint32_t seed;
+  std::vector<std::pair<std::string, float> > parameters;
+};
+
+// Applies the processor settings of a job (FFT size, overlap, texture format,
+// dry delay, post-processing variants) to a processor set up by
+// Renderer::Init(), and its fixed parameter values to the renderer.
+void ConfigureRenderer(const RenderJob& job, Renderer* renderer);
+
+// Renders a job from start to end with the given renderer, reading, processing
+// and writing audio by chunks. Returns false if the job failed; message
+// receives the error, or warnings for a successful job.
+bool RenderFile(const RenderJob& job, Renderer* renderer, std::string* message);
+
+}  // namespace clouds
+
+#endif  // CLOUDS_TEST_RENDER_JOB_H_
@@ -0,0 +1,203 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Drives a GranularProcessor the way the firmware does, for the host tools.
+
+#include "supercell/test/renderer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "supercell/test/automation.h"
+
+namespace clouds {
+
+using namespace std;
+
+static const char* const playback_mode_names[] = {
+  "granular",
+  "stretch",
+  "looping_delay",
+  "spectral",
+  "oliverb",
+  "resonestor",
+  "kammerl",
+  "spectral_cloud"
+};
+
+STATIC_ASSERT(
+    sizeof(playback_mode_names) / sizeof(const char*) == PLAYBACK_MODE_LAST,
+    playback_mode_names_size);
+
+Renderer::Renderer() {
+  // The processor lives in zero-initialized memory, like the global instance
+  // of the firmware which sits in .bss.
+  processor_ = new(calloc(1, sizeof(GranularProcessor))) GranularProcessor;
+  large_buffer_ = static_cast<uint8_t*>(calloc(1, kLargeBufferSize));
+  small_buffer_ = static_cast<uint8_t*>(calloc(1, kSmallBufferSize));
+  automation_ = NULL;
+  block_size_ = kMaxBlockSize;
+  num_frames_ = 0;
+}
+
+Renderer::~Renderer() {
+  processor_->~GranularProcessor();
+  free(processor_);
+  free(large_buffer_);
+  free(small_buffer_);
+}
+
+/* static */
+void Renderer::ResetParameters(Parameters* parameters) {
+  memset(parameters, 0, sizeof(Parameters));
+  parameters->position = 0.5f;
+  parameters->size = 0.5f;
+  parameters->density = 0.5f;
+  parameters->texture = 0.5f;
+  parameters->dry_wet = 1.0f;
+  parameters->kammerl.probability = 1.0f;
+  parameters->kammerl.slice_selection = 0.5f;
+  parameters->kammerl.size_modulation = 0.5f;
+  parameters->kammerl.pitch = 0.5f;
+}
+
+/* static */
+const char* Renderer::playback_mode_name(PlaybackMode mode) {
+  return mode < PLAYBACK_MODE_LAST ? playback_mode_names[mode] : "unknown";
+}
+
+/* static */
+bool Renderer::ParsePlaybackMode(const char* name, PlaybackMode* mode) {
+  for (int32_t i = 0; i < PLAYBACK_MODE_LAST; ++i) {
+    if (!strcmp(name, playback_mode_names[i])) {
+      *mode = static_cast<PlaybackMode>(i);
+      return true;
+    }
+  }
+  char* end;
+  long index = strtol(name, &end, 10);
+  if (*name && !*end && index >= 0 && index < PLAYBACK_MODE_LAST) {
+    *mode = static_cast<PlaybackMode>(index);
+    return true;
+  }
+  return false;
+}
+
+void Renderer::Init(
+    PlaybackMode mode,
+    int32_t quality,
+    size_t block_size,
+    uint32_t seed) {
+  processor_->~GranularProcessor();
+  memset(static_cast<void*>(processor_), 0, sizeof(GranularProcessor));
+  new(processor_) GranularProcessor;
+  memset(large_buffer_, 0, kLargeBufferSize);
+  memset(small_buffer_, 0, kSmallBufferSize);
+
+  processor_->Init(
+      large_buffer_, kLargeBufferSize,
+      small_buffer_, kSmallBufferSize);
+  processor_->Seed(seed);
+  processor_->set_playback_mode(mode);
+  processor_->set_quality(quality);
+  ResetParameters(processor_->mutable_parameters());
+  processor_->Prepare();
+  block_size_ = block_size;
+  num_frames_ = 0;
+  if (automation_) {
+    automation_->Rewind();
+  }
+}
+
+void Renderer::ProcessBlock(
+    ShortFrame* input,
+    ShortFrame* output,
+    size_t size) {
+  if (automation_) {
+    automation_->Apply(
+        static_cast<float>(num_frames_) / kSampleRate,
+        processor_->mutable_parameters());
+  }
+  processor_->Process(input, output, size);
+  processor_->Prepare();
+#ifdef PROFILE_STAGES
+  processor_->mutable_profiler()->Poll();
+#endif  // PROFILE_STAGES
+  num_frames_ += size;
+}
+
+void Renderer::Render(ShortFrame* input, ShortFrame* output, size_t size) {
+  while (size >= block_size_) {
+    ProcessBlock(input, output, block_size_);
+    input += block_size_;
+    output += block_size_;
+    size -= block_size_;
+  }
+  if (size) {
+    // The downsampler of the low-fi modes needs an even number of samples:
+    // pad the last, incomplete block with silence.
+    ShortFrame in[kMaxBlockSize];
+    ShortFrame out[kMaxBlockSize];
+    size_t padded_size = (size + 1) & ~1;
+    memset(in, 0, sizeof(in));
+    memcpy(in, input, size * sizeof(ShortFrame));
+    ProcessBlock(in, out, padded_size);
+    memcpy(output, out, size * sizeof(ShortFrame));
+  }
+}
+
+#ifdef PROFILE_STAGES
+
+void Renderer::PrintProfile(FILE* fp) {
+  const Profiler& profiler = *processor_->mutable_profiler();
+  double ticks_per_block = static_cast<double>(
+      CycleCounter::kTicksPerSecond) * block_size_ / kSampleRate;
+  fprintf(fp, "%-14s %8s %8s %8s %8s %7s  histogram (1/16 of budget)\n",
+      playback_mode_name(static_cast<PlaybackMode>(profiler.context())),
+      "count", "min", "avg", "max", "avg %");
+  for (int32_t i = 0; i < PROFILER_STAGE_LAST; ++i) {
+    ProfilerStage stage = static_cast<ProfilerStage>(i);
+    const ProfilerStats& s = profiler.stats(stage);
+    if (!s.count) {
+      continue;
+    }
+    fprintf(fp, "%-14s %8u %8u %8u %8u %6.1f%% ",
+        Profiler::stage_name(stage), s.count, s.min, s.average(), s.max,
+        100.0 * s.average() / ticks_per_block);
+    for (int32_t j = 0; j < kProfilerHistogramSize; ++j) {
+      fprintf(fp, " %u", s.histogram[j]);
+    }
+    fprintf(fp, "\n");
+  }
+  if (profiler.num_dropped_records()) {
+    fprintf(fp, "(%u records dropped)\n", profiler.num_dropped_records());
+  }
+}
+
+#endif  // PROFILE_STAGES
+
+}  // namespace clouds
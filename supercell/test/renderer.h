@@ -0,0 +1,109 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Drives a GranularProcessor the way the firmware does, for the host tools.
+
+#ifndef CLOUDS_TEST_RENDERER_H_
+#define CLOUDS_TEST_RENDERER_H_
+
+#include "stmlib/stmlib.h"
+
+#include <cstdio>
+
+#include "supercell/dsp/granular_processor.h"
+
+namespace clouds {
+
+class Automation;
+
+// Same sizes as the buffers allocated in supercell.cc.
+const size_t kLargeBufferSize = 118784;
+const size_t kSmallBufferSize = 65536 - 128;
+const float kSampleRate = 32000.0f;
+
+class Renderer {
+ public:
+  Renderer();
+  ~Renderer();
+
+  // Sets up the processor with the same memory as on the module, and the
+  // parameters to a neutral position (knobs at noon, fully wet, no fx). The
+  // processor and its buffers are cleared first, so that the output only
+  // depends on the settings, the seed and the input - not on what was
+  // rendered before.
+  void Init(
+      PlaybackMode mode,
+      int32_t quality,
+      size_t block_size,
+      uint32_t seed);
+
+  // Processes size frames, block by block, calling Prepare() after each block
+  // as the main loop of the firmware does. The input buffer is modified
+  // (mute in is applied in place by the processor).
+  void Render(ShortFrame* input, ShortFrame* output, size_t size);
+
+  inline void set_automation(Automation* automation) {
+    automation_ = automation;
+  }
+
+  inline Parameters* mutable_parameters() {
+    return processor_->mutable_parameters();
+  }
+
+  inline GranularProcessor* processor() { return processor_; }
+  inline size_t block_size() const { return block_size_; }
+  inline size_t num_frames() const { return num_frames_; }
+
+#ifdef PROFILE_STAGES
+  // Prints the per-stage statistics of the processor.
+  void PrintProfile(FILE* fp);
+#endif  // PROFILE_STAGES
+
+  // Sets the parameters to their default value.
+  static void ResetParameters(Parameters* parameters);
+
+  // Mode names as used on the command line of the host tools. A mode can
+  // also be given by its index.
+  static const char* playback_mode_name(PlaybackMode mode);
+  static bool ParsePlaybackMode(const char* name, PlaybackMode* mode);
+
+ private:
+  void ProcessBlock(ShortFrame* input, ShortFrame* output, size_t size);
+
+  GranularProcessor* processor_;
+  uint8_t* large_buffer_;
+  uint8_t* small_buffer_;
+
+  Automation* automation_;
+  size_t block_size_;
+  size_t num_frames_;
+
+  DISALLOW_COPY_AND_ASSIGN(Renderer);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_TEST_RENDERER_H_
@@ -0,0 +1,136 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Writer of the spectrum files of clouds_spectrum.
+
+#include "supercell/test/spectrum_file.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "supercell/dsp/pvoc/polar_conversion.h"
+#include "supercell/resources.h"
+
+namespace clouds {
+
+using namespace std;
+
+namespace {
+
+const uint16_t kVersion = 1;
+const size_t kIoBufferSize = 1 << 20;
+
+// Below -128 dB, the magnitudes are clipped.
+const float kMinMagnitude = 3.9810717e-7f;
+
+}  // namespace
+
+bool SpectrumWriter::Open(
+    const char* file_name,
+    const SpectrumFileHeader& header) {
+  Close();
+  fp_ = fopen(file_name, "wb");
+  if (!fp_) {
+    return false;
+  }
+  io_buffer_.resize(kIoBufferSize);
+  setvbuf(fp_, &io_buffer_[0], _IOFBF, io_buffer_.size());
+  header_ = header;
+  memcpy(header_.magic, "PVOC", 4);
+  header_.version = kVersion;
+  header_.num_frames = 0;
+
+  // A sine of amplitude A has a magnitude of A / 2 times the sum of the
+  // window, the analysed samples being scaled to 16-bit by the STFT.
+  size_t stride = LUT_SINE_WINDOW_4096_SIZE / header_.fft_size;
+  float window_sum = 0.0f;
+  for (size_t i = 0; i < header_.fft_size; ++i) {
+    window_sum += lut_sine_window_4096[i * stride];
+  }
+  scale_ = 1.0f / (16384.0f * window_sum);
+
+  magnitude_.resize(header_.num_bins);
+  phase_.resize(header_.num_bins);
+  db_.resize(header_.num_bins);
+  frame_.resize(header_.frame_size());
+  WriteHeader();
+  return true;
+}
+
+void SpectrumWriter::WriteHeader() {
+  // Host tools only run on little-endian machines, the header is written
+  // as-is.
+  fwrite(&header_, sizeof(header_), 1, fp_);
+}
+
+bool SpectrumWriter::Write(const float* const* spectra) {
+  size_t num_bins = header_.num_bins;
+  size_t half = header_.fft_size >> 1;
+  uint8_t* p = &frame_[0];
+  for (size_t i = 0; i < header_.num_spectra; ++i) {
+    ConvertToPolar(
+        &spectra[i][0], &spectra[i][half], &magnitude_[0], &phase_[0],
+        num_bins);
+    if (header_.flags & SPECTRUM_FLAG_DB) {
+      for (size_t j = 0; j < num_bins; ++j) {
+        float m = max(magnitude_[j] * scale_, kMinMagnitude);
+        float value = 20.0f * 256.0f * log10f(m);
+        db_[j] = static_cast<int16_t>(
+            min(max(value + (value < 0.0f ? -0.5f : 0.5f), -32768.0f),
+                32767.0f));
+      }
+      memcpy(p, &db_[0], num_bins * sizeof(int16_t));
+      p += num_bins * sizeof(int16_t);
+    } else {
+      for (size_t j = 0; j < num_bins; ++j) {
+        magnitude_[j] *= scale_;
+      }
+      memcpy(p, &magnitude_[0], num_bins * sizeof(float));
+      p += num_bins * sizeof(float);
+    }
+    if (header_.flags & SPECTRUM_FLAG_PHASES) {
+      memcpy(p, &phase_[0], num_bins * sizeof(uint16_t));
+      p += num_bins * sizeof(uint16_t);
+    }
+  }
+  if (fwrite(&frame_[0], frame_.size(), 1, fp_) != 1) {
+    return false;
+  }
+  ++header_.num_frames;
+  return true;
+}
+
+void SpectrumWriter::Close() {
+  if (fp_) {
+    fflush(fp_);
+    fseek(fp_, 0, SEEK_SET);
+    WriteHeader();
+    fclose(fp_);
+    fp_ = NULL;
+  }
+}
+
+}  // namespace clouds
@@ -0,0 +1,110 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Writer of the spectrum files of clouds_spectrum: the spectra seen by a
+// modifier of the phase vocoder, hop after hop.
+//
+// All values are little-endian. A file starts with a SpectrumFileHeader,
+// followed by num_frames frames of frame_size() bytes. Each frame holds
+// num_spectra spectra - the input of the modifier, then its output, when
+// both are recorded - and each spectrum num_bins magnitudes, followed by
+// num_bins phases if SPECTRUM_FLAG_PHASES is set. The frames all having
+// the same size, and being packed without padding, a file can be mapped as
+// is, for example with numpy.memmap.
+//
+// Magnitudes are relative to the magnitude of a full scale sine: floats, or
+// with SPECTRUM_FLAG_DB, 16-bit signed values in 1/256 dB. Phases are 16-bit
+// unsigned values in 1/65536 of a turn.
+
+#ifndef CLOUDS_TEST_SPECTRUM_FILE_H_
+#define CLOUDS_TEST_SPECTRUM_FILE_H_
+
+#include <cstdio>
+#include <vector>
+
+#include "stmlib/stmlib.h"
+
+namespace clouds {
+
+enum SpectrumFlags {
+  SPECTRUM_FLAG_DB = 1,
+  SPECTRUM_FLAG_PHASES = 2
+};
+
+struct SpectrumFileHeader {
+  char magic[4];  // "PVOC"
+  uint16_t version;
+  uint16_t flags;
+  uint32_t sample_rate;
+  uint32_t fft_size;
+  uint32_t hop_size;  // Between two frames.
+  uint32_t num_bins;
+  uint32_t num_spectra;
+  uint32_t num_frames;
+
+  inline size_t frame_size() const {
+    size_t spectrum_size = num_bins * (
+        (flags & SPECTRUM_FLAG_DB ? sizeof(int16_t) : sizeof(float)) + \
+        (flags & SPECTRUM_FLAG_PHASES ? sizeof(uint16_t) : 0));
+    return num_spectra * spectrum_size;
+  }
+};
+
+class SpectrumWriter {
+ public:
+  SpectrumWriter() : fp_(NULL) { }
+  ~SpectrumWriter() { Close(); }
+
+  // The magic, version and number of frames of header are filled in.
+  bool Open(const char* file_name, const SpectrumFileHeader& header);
+  // Writes the final number of frames in the header and closes the file.
+  void Close();
+
+  // Writes a frame from header.num_spectra spectra in the layout of the
+  // buffers given to Modifier::Process(): the real parts of the fft_size / 2
+  // bins, then their imaginary parts.
+  bool Write(const float* const* spectra);
+
+  inline const SpectrumFileHeader& header() const { return header_; }
+
+ private:
+  void WriteHeader();
+
+  FILE* fp_;
+  SpectrumFileHeader header_;
+  float scale_;
+  std::vector<float> magnitude_;
+  std::vector<uint16_t> phase_;
+  std::vector<int16_t> db_;
+  std::vector<uint8_t> frame_;
+  std::vector<char> io_buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpectrumWriter);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_TEST_SPECTRUM_FILE_H_
@@ -0,0 +1,242 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Minimal WAV file reader/writer for the host tools.
+
+#include "supercell/test/wav_file.h"
+
+#include <cstring>
+
+namespace clouds {
+
+using namespace std;
+
+namespace {
+
+const uint16_t kFormatPcm = 1;
+const uint16_t kFormatFloat = 3;
+const uint16_t kFormatExtensible = 0xfffe;
+
+// Large stdio buffers so that long renders are bound by the DSP, not by I/O.
+const size_t kIoBufferSize = 1 << 20;
+
+inline uint16_t ReadLe16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+inline uint32_t ReadLe32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline void WriteLe16(uint8_t* p, uint16_t value) {
+  p[0] = value & 0xff;
+  p[1] = value >> 8;
+}
+
+inline void WriteLe32(uint8_t* p, uint32_t value) {
+  WriteLe16(p, value & 0xffff);
+  WriteLe16(p + 2, value >> 16);
+}
+
+inline short ConvertSample(
+    const uint8_t* p,
+    uint16_t bits_per_sample,
+    bool floating_point) {
+  if (floating_point) {
+    uint32_t word = ReadLe32(p);
+    float f;
+    memcpy(&f, &word, sizeof(f));
+    f *= 32768.0f;
+    if (!(f > -32768.0f)) {
+      f = -32768.0f;
+    } else if (f > 32767.0f) {
+      f = 32767.0f;
+    }
+    return static_cast<short>(f);
+  }
+  switch (bits_per_sample) {
+    case 8:
+      return static_cast<short>((p[0] - 128) << 8);
+    case 16:
+      return static_cast<short>(ReadLe16(p));
+    case 24:
+      return static_cast<short>(ReadLe16(p + 1));
+    default:
+      return static_cast<short>(ReadLe16(p + 2));
+  }
+}
+
+}  // namespace
+
+bool WavReader::Open(const char* file_name) {
+  Close();
+  fp_ = fopen(file_name, "rb");
+  if (!fp_) {
+    return false;
+  }
+  setvbuf(fp_, NULL, _IOFBF, kIoBufferSize);
+
+  uint8_t header[12];
+  if (fread(header, 1, 12, fp_) != 12 ||
+      memcmp(header, "RIFF", 4) || memcmp(header + 8, "WAVE", 4)) {
+    Close();
+    return false;
+  }
+
+  bool has_format = false;
+  uint16_t format = 0;
+  while (true) {
+    uint8_t chunk[8];
+    if (fread(chunk, 1, 8, fp_) != 8) {
+      break;
+    }
+    uint32_t chunk_size = ReadLe32(chunk + 4);
+    if (!memcmp(chunk, "fmt ", 4)) {
+      uint8_t fmt[40];
+      memset(fmt, 0, sizeof(fmt));
+      size_t size = chunk_size < sizeof(fmt) ? chunk_size : sizeof(fmt);
+      if (chunk_size < 16 || fread(fmt, 1, size, fp_) != size) {
+        break;
+      }
+      format = ReadLe16(fmt);
+      num_channels_ = ReadLe16(fmt + 2);
+      sample_rate_ = ReadLe32(fmt + 4);
+      bits_per_sample_ = ReadLe16(fmt + 14);
+      if (format == kFormatExtensible && chunk_size >= 26) {
+        // The first two bytes of the sub-format GUID hold the actual format.
+        format = ReadLe16(fmt + 24);
+      }
+      fseek(fp_, chunk_size - size + (chunk_size & 1), SEEK_CUR);
+      has_format = true;
+    } else if (!memcmp(chunk, "data", 4)) {
+      if (!has_format) {
+        break;
+      }
+      floating_point_ = format == kFormatFloat;
+      bool supported = num_channels_ != 0 && (floating_point_
+          ? bits_per_sample_ == 32
+          : format == kFormatPcm && (bits_per_sample_ == 8 ||
+                                     bits_per_sample_ == 16 ||
+                                     bits_per_sample_ == 24 ||
+                                     bits_per_sample_ == 32));
+      if (!supported) {
+        break;
+      }
+      num_frames_ = chunk_size / (num_channels_ * (bits_per_sample_ >> 3));
+      remaining_frames_ = num_frames_;
+      return true;
+    } else {
+      fseek(fp_, chunk_size + (chunk_size & 1), SEEK_CUR);
+    }
+  }
+  Close();
+  return false;
+}
+
+void WavReader::Close() {
+  if (fp_) {
+    fclose(fp_);
+    fp_ = NULL;
+  }
+}
+
+size_t WavReader::Read(ShortFrame* frames, size_t size) {
+  if (!fp_) {
+    return 0;
+  }
+  if (size > remaining_frames_) {
+    size = remaining_frames_;
+  }
+  size_t sample_size = bits_per_sample_ >> 3;
+  size_t frame_size = num_channels_ * sample_size;
+  raw_.resize(size * frame_size);
+  if (!size) {
+    return 0;
+  }
+  size = fread(&raw_[0], frame_size, size, fp_);
+  remaining_frames_ -= size;
+
+  const uint8_t* p = &raw_[0];
+  size_t right_offset = num_channels_ > 1 ? sample_size : 0;
+  for (size_t i = 0; i < size; ++i) {
+    frames[i].l = ConvertSample(p, bits_per_sample_, floating_point_);
+    frames[i].r = ConvertSample(
+        p + right_offset, bits_per_sample_, floating_point_);
+    p += frame_size;
+  }
+  return size;
+}
+
+bool WavWriter::Open(const char* file_name, uint32_t sample_rate) {
+  Close();
+  fp_ = fopen(file_name, "wb");
+  if (!fp_) {
+    return false;
+  }
+  io_buffer_.resize(kIoBufferSize);
+  setvbuf(fp_, &io_buffer_[0], _IOFBF, io_buffer_.size());
+  sample_rate_ = sample_rate;
+  num_frames_ = 0;
+  WriteHeader();
+  return true;
+}
+
+void WavWriter::WriteHeader() {
+  uint8_t header[44];
+  uint32_t data_size = num_frames_ * sizeof(ShortFrame);
+  memcpy(header, "RIFF", 4);
+  WriteLe32(header + 4, 36 + data_size);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  WriteLe32(header + 16, 16);
+  WriteLe16(header + 20, kFormatPcm);
+  WriteLe16(header + 22, 2);
+  WriteLe32(header + 24, sample_rate_);
+  WriteLe32(header + 28, sample_rate_ * sizeof(ShortFrame));
+  WriteLe16(header + 32, sizeof(ShortFrame));
+  WriteLe16(header + 34, 16);
+  memcpy(header + 36, "data", 4);
+  WriteLe32(header + 40, data_size);
+  fwrite(header, 1, sizeof(header), fp_);
+}
+
+bool WavWriter::Write(const ShortFrame* frames, size_t size) {
+  // Host tools only run on little-endian machines, so frames are written as-is.
+  size_t written = fwrite(frames, sizeof(ShortFrame), size, fp_);
+  num_frames_ += written;
+  return written == size;
+}
+
+void WavWriter::Close() {
+  if (fp_) {
+    fflush(fp_);
+    fseek(fp_, 0, SEEK_SET);
+    WriteHeader();
+    fclose(fp_);
+    fp_ = NULL;
+  }
+}
+
+}  // namespace clouds
@@ -0,0 +1,100 @@
+// Copyright 2019 Patrick Dowling
+//
+// Author: Patrick Dowling (pld@gurkenkiste.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// 
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Minimal WAV file reader/writer for the host tools. Reads 16/24/32-bit PCM
+// and 32-bit float files (plain or WAVE_FORMAT_EXTENSIBLE) and converts them
+// to the stereo 16-bit frames consumed by the processor; writes 16-bit stereo.
+
+#ifndef CLOUDS_TEST_WAV_FILE_H_
+#define CLOUDS_TEST_WAV_FILE_H_
+
+#include <cstdio>
+#include <vector>
+
+#include "stmlib/stmlib.h"
+
+#include "supercell/dsp/frame.h"
+
+namespace clouds {
+
+class WavReader {
+ public:
+  WavReader() : fp_(NULL) { }
+  ~WavReader() { Close(); }
+
+  bool Open(const char* file_name);
+  void Close();
+
+  // Reads up to size frames, returns the number of frames actually read.
+  // Mono files are duplicated on both channels, extra channels are dropped.
+  size_t Read(ShortFrame* frames, size_t size);
+
+  inline uint32_t sample_rate() const { return sample_rate_; }
+  inline uint16_t num_channels() const { return num_channels_; }
+  inline uint16_t bits_per_sample() const { return bits_per_sample_; }
+  inline bool floating_point() const { return floating_point_; }
+  inline size_t num_frames() const { return num_frames_; }
+
+ private:
+  FILE* fp_;
+  uint32_t sample_rate_;
+  uint16_t num_channels_;
+  uint16_t bits_per_sample_;
+  bool floating_point_;
+  size_t num_frames_;
+  size_t remaining_frames_;
+  std::vector<uint8_t> raw_;
+
+  DISALLOW_COPY_AND_ASSIGN(WavReader);
+};
+
+class WavWriter {
+ public:
+  WavWriter() : fp_(NULL) { }
+  ~WavWriter() { Close(); }
+
+  bool Open(const char* file_name, uint32_t sample_rate);
+  // Patches the RIFF and data chunk sizes and closes the file.
+  void Close();
+
+  bool Write(const ShortFrame* frames, size_t size);
+
+  inline size_t num_frames() const { return num_frames_; }
+
+ private:
+  void WriteHeader();
+
+  FILE* fp_;
+  uint32_t sample_rate_;
+  size_t num_frames_;
+  std::vector<char> io_buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(WavWriter);
+};
+
+}  // namespace clouds
+
+#endif  // CLOUDS_TEST_WAV_FILE_H_
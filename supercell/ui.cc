@@ -76,7 +76,10 @@ void Ui::Init(
   mode_alt_menu_ = false;
   save_menu_time_ = 0;
   mode_menu_time_ = 0;
-  // Sanitize saved settings.
+  // Sanitize saved settings. The FFT size and overlap of the spectral modes,
+  // their texture format and dry delay, and the decimated or fixed-point
+  // effects of the low-fidelity qualities have no control on the module yet,
+  // and keep the defaults set by GranularProcessor::Init().
   processor_->set_quality(state.quality & 3);
   processor_->set_playback_mode(
       static_cast<PlaybackMode>(state.playback_mode % PLAYBACK_MODE_LAST));
@@ -372,6 +375,7 @@ void Ui::OnSwitchReleased(const Event& e) {
             processor_->PreparePersistentData();
             processor_->GetPersistentData(blocks, &num_blocks);
             settings_->SaveSampleMemory(load_save_location_, blocks, num_blocks);
+            processor_->ReleasePersistentData();
             processor_->set_silence(false);
 
             processor_->LoadPersistentData(settings_->sample_flash_data(